@@ -0,0 +1,334 @@
+// dynaalign: the DynaAlign similarity kernels without R
+//
+// Streams sequences from FASTA or plain-text files (memory-mapped, or "-"
+// for standard input), sketches them into signature stores and writes
+// pairwise similarities as tab-separated edge lists with 1-based indices,
+// using the same headers as the R package. See `dynaalign --help`.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "coreError.hpp"
+#include "minHash.hpp"
+#include "needlemanWunsch.hpp"
+#include "packedSignatures.hpp"
+#include "pairScheduler.hpp"
+#include "sequenceReader.hpp"
+#include "signatureStore.hpp"
+#include "sparseSimilarity.hpp"
+
+using namespace std;
+
+static const char* USAGE =
+  "Usage: dynaalign <command> [options] <input>\n"
+  "\n"
+  "Commands:\n"
+  "  sketch   Sketch the sequences of <input> into the signature store given by -o\n"
+  "  mh       MinHash similarities of <input>, a sequence file or a signature store\n"
+  "  nw       Needleman-Wunsch similarities of the sequences of <input>\n"
+  "\n"
+  "<input> is a FASTA file, a text file with one sequence per line, or - for\n"
+  "standard input. Similarities are written as `i<TAB>j<TAB>score` lines with\n"
+  "1-based i < j, for pairs with a score above zero and at least --threshold.\n"
+  "\n"
+  "Options:\n"
+  "  -o, --output FILE     Output file (default: standard output; required for sketch)\n"
+  "  --threads N           Number of threads (default: all cores)\n"
+  "  --chunk N             Sequences read and sketched per batch (default: 100000)\n"
+  "  --threshold X         Minimum similarity of a written pair (default: 0)\n"
+  "  --top-k N             Keep each sequence's N most similar neighbours (default: 0, all)\n"
+  "  -k N                  MinHash k-mer length (default: 4)\n"
+  "  --n-hash N            Number of hash functions (default: 100)\n"
+  "  --method NAME         Sketch method: mix, oph or classic (default: mix)\n"
+  "  --bits N              Bits per signature slot: 1, 2, 4, 8, 16 or 32 (default: 32)\n"
+  "  --seed N              Seed of the hash functions (default: 42)\n"
+  "  --signatures FILE     mh: also keep the sketched signatures in this store\n"
+  "  --matrix NAME         nw: substitution matrix (default: BLOSUM62)\n"
+  "  --gap-open N          nw: gap opening penalty (default: 10)\n"
+  "  --gap-ext N           nw: gap extension penalty (default: 4)\n"
+  "  --band N              nw: band width, -1 none, 0 automatic (default: -1)\n"
+  "  --engine NAME         nw: simd or scalar (default: simd)\n";
+
+// Parsed command line: option values by name, and the positional arguments
+struct Arguments {
+  map<string, string> options;
+  vector<string> positional;
+
+  string get(const string& name, const string& fallback) const {
+    map<string, string>::const_iterator it = options.find(name);
+    return it == options.end() ? fallback : it->second;
+  }
+
+  long integer(const string& name, long fallback) const {
+    string value = get(name, "");
+    if (value.empty()) {
+      return fallback;
+    }
+    char* end = 0;
+    long parsed = strtol(value.c_str(), &end, 10);
+    if (*end != '\0') {
+      core_stop("Option --%s expects an integer, not '%s'", name, value);
+    }
+    return parsed;
+  }
+
+  double real(const string& name, double fallback) const {
+    string value = get(name, "");
+    if (value.empty()) {
+      return fallback;
+    }
+    char* end = 0;
+    double parsed = strtod(value.c_str(), &end);
+    if (*end != '\0') {
+      core_stop("Option --%s expects a number, not '%s'", name, value);
+    }
+    return parsed;
+  }
+};
+
+static Arguments parse_arguments(int argc, char** argv) {
+  Arguments args;
+  for (int a = 2; a < argc; ++a) {
+    string arg = argv[a];
+    if (arg == "-" || arg.empty() || arg[0] != '-') {
+      args.positional.push_back(arg);
+      continue;
+    }
+    string name = arg == "-o" ? "output" : arg == "-k" ? "k" : arg.substr(2);
+    if (arg.compare(0, 2, "--") != 0 && arg != "-o" && arg != "-k") {
+      core_stop("Unknown option: %s", arg);
+    }
+    if (a + 1 >= argc) {
+      core_stop("Option %s expects a value", arg);
+    }
+    args.options[name] = argv[++a];
+  }
+  return args;
+}
+
+// Output stream for -o, or standard output
+class Output {
+private:
+  ofstream file;
+
+public:
+  explicit Output(const string& path) {
+    if (!path.empty() && path != "-") {
+      file.open(path.c_str());
+      if (!file) {
+        core_stop("Cannot create output file: %s", path);
+      }
+    }
+  }
+
+  ostream& stream() {
+    return file.is_open() ? static_cast<ostream&>(file) : cout;
+  }
+};
+
+static void write_edges(const SparseSimilarity& similarity, ostream& out) {
+  vector<SimilarityEdge> edges = similarity.edges();
+  char line[64];
+  for (const SimilarityEdge& edge : edges) {
+    snprintf(line, sizeof(line), "%d\t%d\t%.6g\n", edge.i + 1, edge.j + 1, edge.score);
+    out << line;
+  }
+  if (!out) {
+    core_stop("Cannot write the output");
+  }
+}
+
+// Whether `path` starts with the signature store magic
+static bool is_signature_store(const string& path) {
+  if (path == "-") {
+    return false;
+  }
+  ifstream in(path.c_str(), ios::binary);
+  char magic[sizeof(SIGNATURE_STORE_MAGIC)] = {0};
+  in.read(magic, sizeof(magic) - 1);
+  return in && memcmp(magic, SIGNATURE_STORE_MAGIC, sizeof(magic) - 1) == 0;
+}
+
+// Sketch every sequence of `input` into a new store at `path`, one chunk of
+// sequences at a time
+static SignatureStoreHeader sketch_to_store(const Arguments& args, const string& input,
+                                            const string& path) {
+  int k = static_cast<int>(args.integer("k", 4));
+  int n_hash = static_cast<int>(args.integer("n-hash", 100));
+  int bits = static_cast<int>(args.integer("bits", 32));
+  long seed = args.integer("seed", 42);
+  long chunk = args.integer("chunk", 100000);
+  if (k <= 0) {
+    core_stop("-k must be a positive integer");
+  }
+  if (n_hash <= 0) {
+    core_stop("--n-hash must be a positive integer");
+  }
+  if (!valid_signature_bits(bits)) {
+    core_stop("--bits must be one of 1, 2, 4, 8, 16 or 32");
+  }
+  if (seed < 0) {
+    core_stop("--seed must be a non-negative integer");
+  }
+  if (chunk <= 0) {
+    core_stop("--chunk must be a positive integer");
+  }
+
+  SignatureStoreHeader header = make_store_header(k, n_hash,
+                                                  parse_sketch_method(args.get("method", "mix")),
+                                                  bits, static_cast<uint32_t>(seed));
+  header = create_signature_store(path, vector<string>(), header);
+  SequenceReader reader(input);
+  vector<string> batch;
+  while (reader.next_batch(batch, static_cast<size_t>(chunk))) {
+    header = append_signature_store(path, batch);
+  }
+  return header;
+}
+
+static int run_sketch(const Arguments& args, const string& input) {
+  string path = args.get("output", "");
+  if (path.empty() || path == "-") {
+    core_stop("sketch needs an output store: -o FILE");
+  }
+  SignatureStoreHeader header = sketch_to_store(args, input, path);
+  cerr << "Sketched " << header.n << " sequences into " << path << "\n";
+  return 0;
+}
+
+// A temporary file, removed when the object goes out of scope
+class TemporaryFile {
+private:
+  string name;
+
+public:
+  TemporaryFile() {
+    char pattern[] = "/tmp/dynaalign-XXXXXX";
+    int fd = mkstemp(pattern);
+    if (fd < 0) {
+      core_stop("Cannot create a temporary file");
+    }
+    close(fd);
+    name = pattern;
+  }
+
+  ~TemporaryFile() {
+    remove(name.c_str());
+  }
+
+  const string& path() const {
+    return name;
+  }
+};
+
+static int run_mh(const Arguments& args, const string& input) {
+  // Sequences are sketched into a store first, then compared in place
+  string store_path = input;
+  unique_ptr<TemporaryFile> temporary;
+  if (!is_signature_store(input)) {
+    store_path = args.get("signatures", "");
+    if (store_path.empty()) {
+      temporary.reset(new TemporaryFile());
+      store_path = temporary->path();
+    }
+    sketch_to_store(args, input, store_path);
+  }
+
+  SignatureStore store(store_path);
+  PackedSignatures signatures = store.signatures();
+  SparseSimilarity similarity(signatures.size(), args.real("threshold", 0.0),
+                              static_cast<int>(args.integer("top-k", 0)));
+  for_each_pair_tiled(signatures.size(), signature_tile_rows(signatures),
+                      [&](size_t i, size_t j) {
+    similarity.add(static_cast<int>(i), static_cast<int>(j), signatures.similarity(i, j));
+  });
+  Output output(args.get("output", ""));
+  write_edges(similarity, output.stream());
+  return 0;
+}
+
+static int run_nw(const Arguments& args, const string& input) {
+  int gap_open = static_cast<int>(args.integer("gap-open", 10));
+  int gap_ext = static_cast<int>(args.integer("gap-ext", 4));
+  int band = static_cast<int>(args.integer("band", -1));
+  long chunk = args.integer("chunk", 100000);
+  string engine = args.get("engine", "simd");
+  if (band < -1) {
+    core_stop("--band must be -1 (no band), 0 (automatic) or a positive width");
+  }
+  if (chunk <= 0) {
+    core_stop("--chunk must be a positive integer");
+  }
+  if (engine != "simd" && engine != "scalar") {
+    core_stop("--engine must be simd or scalar");
+  }
+  const int (*substitution_matrix)[24] = getSubstitutionMatrix(args.get("matrix", "BLOSUM62"));
+
+  // Encode chunk by chunk; the raw sequences of a chunk are dropped once encoded
+  vector<vector<uint8_t>> encoded;
+  SequenceReader reader(input);
+  vector<string> batch;
+  while (reader.next_batch(batch, static_cast<size_t>(chunk))) {
+    vector<vector<uint8_t>> codes = encode_sequences(batch, encoded.size());
+    for (vector<uint8_t>& code : codes) {
+      encoded.push_back(vector<uint8_t>());
+      encoded.back().swap(code);
+    }
+  }
+
+  double threshold = args.real("threshold", 0.0);
+  int n_threads = resolve_threads(0);
+  SparseSimilarity similarity(encoded.size(), threshold,
+                              static_cast<int>(args.integer("top-k", 0)), n_threads);
+  vector<NWWorkspace> workspaces(n_threads);
+  bool use_simd = engine == "simd" && nw_simd_available(substitution_matrix, band);
+  for_each_alignment(encoded, substitution_matrix, gap_open, gap_ext, band, threshold, use_simd,
+                     n_threads, workspaces, [&](size_t i, size_t j, double score) {
+    similarity.add(static_cast<int>(i), static_cast<int>(j), score);
+  });
+  Output output(args.get("output", ""));
+  write_edges(similarity, output.stream());
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+    cout << USAGE;
+    return argc < 2 ? 1 : 0;
+  }
+  try {
+    string command = argv[1];
+    Arguments args = parse_arguments(argc, argv);
+    if (args.positional.size() != 1) {
+      core_stop("Expected exactly one input file, see dynaalign --help");
+    }
+    long threads = args.integer("threads", 0);
+    if (threads < 0) {
+      core_stop("--threads must be a non-negative integer");
+    }
+#ifdef _OPENMP
+    if (threads > 0) {
+      omp_set_num_threads(static_cast<int>(threads));
+    }
+#endif
+    if (command == "sketch") {
+      return run_sketch(args, args.positional[0]);
+    } else if (command == "mh") {
+      return run_mh(args, args.positional[0]);
+    } else if (command == "nw") {
+      return run_nw(args, args.positional[0]);
+    }
+    core_stop("Unknown command: %s", command);
+  } catch (const exception& e) {
+    cerr << "dynaalign: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
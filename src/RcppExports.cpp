@@ -10,22 +10,142 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// benchmarkKernels
+DataFrame benchmarkKernels(CharacterVector sequences, Rcpp::Nullable<Rcpp::IntegerVector> threads, CharacterVector kernels, int reps, int k, int n_hash, std::string method, int bits, std::string matrixName, int gapOpen, int gapExt, int band);
+RcppExport SEXP _DynaAlign_benchmarkKernels(SEXP sequencesSEXP, SEXP threadsSEXP, SEXP kernelsSEXP, SEXP repsSEXP, SEXP kSEXP, SEXP n_hashSEXP, SEXP methodSEXP, SEXP bitsSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP, SEXP bandSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::IntegerVector> >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type kernels(kernelsSEXP);
+    Rcpp::traits::input_parameter< int >::type reps(repsSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type matrixName(matrixNameSEXP);
+    Rcpp::traits::input_parameter< int >::type gapOpen(gapOpenSEXP);
+    Rcpp::traits::input_parameter< int >::type gapExt(gapExtSEXP);
+    Rcpp::traits::input_parameter< int >::type band(bandSEXP);
+    rcpp_result_gen = Rcpp::wrap(benchmarkKernels(sequences, threads, kernels, reps, k, n_hash, method, bits, matrixName, gapOpen, gapExt, band));
+    return rcpp_result_gen;
+END_RCPP
+}
+// clusterbreakNative
+List clusterbreakNative(CharacterVector sequences, double thresh_p, int size_max, int size_min, int max_itr, bool weighted, std::string signatures, double resolution, int restarts, int seed, int threads);
+RcppExport SEXP _DynaAlign_clusterbreakNative(SEXP sequencesSEXP, SEXP thresh_pSEXP, SEXP size_maxSEXP, SEXP size_minSEXP, SEXP max_itrSEXP, SEXP weightedSEXP, SEXP signaturesSEXP, SEXP resolutionSEXP, SEXP restartsSEXP, SEXP seedSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< double >::type thresh_p(thresh_pSEXP);
+    Rcpp::traits::input_parameter< int >::type size_max(size_maxSEXP);
+    Rcpp::traits::input_parameter< int >::type size_min(size_minSEXP);
+    Rcpp::traits::input_parameter< int >::type max_itr(max_itrSEXP);
+    Rcpp::traits::input_parameter< bool >::type weighted(weightedSEXP);
+    Rcpp::traits::input_parameter< std::string >::type signatures(signaturesSEXP);
+    Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< int >::type restarts(restartsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(clusterbreakNative(sequences, thresh_p, size_max, size_min, max_itr, weighted, signatures, resolution, restarts, seed, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// clusterLouvain
+List clusterLouvain(SEXP similarity, NumericVector resolution, int restarts, bool refine, bool weighted, int seed, int threads);
+RcppExport SEXP _DynaAlign_clusterLouvain(SEXP similaritySEXP, SEXP resolutionSEXP, SEXP restartsSEXP, SEXP refineSEXP, SEXP weightedSEXP, SEXP seedSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type similarity(similaritySEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type resolution(resolutionSEXP);
+    Rcpp::traits::input_parameter< int >::type restarts(restartsSEXP);
+    Rcpp::traits::input_parameter< bool >::type refine(refineSEXP);
+    Rcpp::traits::input_parameter< bool >::type weighted(weightedSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(clusterLouvain(similarity, resolution, restarts, refine, weighted, seed, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// consensusSequences
+CharacterVector consensusSequences(CharacterVector sequences, IntegerVector clusters, std::string matrixName, int gapOpen, int gapExt, int threads);
+RcppExport SEXP _DynaAlign_consensusSequences(SEXP sequencesSEXP, SEXP clustersSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type clusters(clustersSEXP);
+    Rcpp::traits::input_parameter< std::string >::type matrixName(matrixNameSEXP);
+    Rcpp::traits::input_parameter< int >::type gapOpen(gapOpenSEXP);
+    Rcpp::traits::input_parameter< int >::type gapExt(gapExtSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(consensusSequences(sequences, clusters, matrixName, gapOpen, gapExt, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// collapseDuplicates
+List collapseDuplicates(CharacterVector sequences);
+RcppExport SEXP _DynaAlign_collapseDuplicates(SEXP sequencesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    rcpp_result_gen = Rcpp::wrap(collapseDuplicates(sequences));
+    return rcpp_result_gen;
+END_RCPP
+}
 // similarityMH
-NumericMatrix similarityMH(CharacterVector sequences, int k, int n_hash);
-RcppExport SEXP _DynaAlign_similarityMH(SEXP sequencesSEXP, SEXP kSEXP, SEXP n_hashSEXP) {
+SEXP similarityMH(CharacterVector sequences, int k, int n_hash, std::string method, int bits, bool sparse, double threshold, int top_k, double cut_quantile, bool profile, std::string dedup, std::string tile_path, double memory_mb, std::string type, bool packed, bool dimnames);
+RcppExport SEXP _DynaAlign_similarityMH(SEXP sequencesSEXP, SEXP kSEXP, SEXP n_hashSEXP, SEXP methodSEXP, SEXP bitsSEXP, SEXP sparseSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP cut_quantileSEXP, SEXP profileSEXP, SEXP dedupSEXP, SEXP tile_pathSEXP, SEXP memory_mbSEXP, SEXP typeSEXP, SEXP packedSEXP, SEXP dimnamesSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
     Rcpp::traits::input_parameter< int >::type k(kSEXP);
     Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
-    rcpp_result_gen = Rcpp::wrap(similarityMH(sequences, k, n_hash));
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< bool >::type sparse(sparseSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< double >::type cut_quantile(cut_quantileSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< std::string >::type dedup(dedupSEXP);
+    Rcpp::traits::input_parameter< std::string >::type tile_path(tile_pathSEXP);
+    Rcpp::traits::input_parameter< double >::type memory_mb(memory_mbSEXP);
+    Rcpp::traits::input_parameter< std::string >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< bool >::type dimnames(dimnamesSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityMH(sequences, k, n_hash, method, bits, sparse, threshold, top_k, cut_quantile, profile, dedup, tile_path, memory_mb, type, packed, dimnames));
+    return rcpp_result_gen;
+END_RCPP
+}
+// similarityLSH
+DataFrame similarityLSH(CharacterVector sequences, int k, int bands, int rows, std::string method, int bits, double threshold, int top_k, int max_bucket, int seed);
+RcppExport SEXP _DynaAlign_similarityLSH(SEXP sequencesSEXP, SEXP kSEXP, SEXP bandsSEXP, SEXP rowsSEXP, SEXP methodSEXP, SEXP bitsSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP max_bucketSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type bands(bandsSEXP);
+    Rcpp::traits::input_parameter< int >::type rows(rowsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type max_bucket(max_bucketSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityLSH(sequences, k, bands, rows, method, bits, threshold, top_k, max_bucket, seed));
     return rcpp_result_gen;
 END_RCPP
 }
 // similarityNW
-NumericMatrix similarityNW(CharacterVector sequences, std::string matrixName, int gapOpen, int gapExt);
-RcppExport SEXP _DynaAlign_similarityNW(SEXP sequencesSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP) {
+SEXP similarityNW(CharacterVector sequences, std::string matrixName, int gapOpen, int gapExt, bool sparse, double threshold, int top_k, int threads, std::string engine, int band, double cutoff, double cut_quantile, bool profile, std::string dedup, std::string tile_path, double memory_mb, std::string type, bool packed, bool dimnames);
+RcppExport SEXP _DynaAlign_similarityNW(SEXP sequencesSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP, SEXP sparseSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP threadsSEXP, SEXP engineSEXP, SEXP bandSEXP, SEXP cutoffSEXP, SEXP cut_quantileSEXP, SEXP profileSEXP, SEXP dedupSEXP, SEXP tile_pathSEXP, SEXP memory_mbSEXP, SEXP typeSEXP, SEXP packedSEXP, SEXP dimnamesSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -33,14 +153,274 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< std::string >::type matrixName(matrixNameSEXP);
     Rcpp::traits::input_parameter< int >::type gapOpen(gapOpenSEXP);
     Rcpp::traits::input_parameter< int >::type gapExt(gapExtSEXP);
-    rcpp_result_gen = Rcpp::wrap(similarityNW(sequences, matrixName, gapOpen, gapExt));
+    Rcpp::traits::input_parameter< bool >::type sparse(sparseSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type engine(engineSEXP);
+    Rcpp::traits::input_parameter< int >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< double >::type cutoff(cutoffSEXP);
+    Rcpp::traits::input_parameter< double >::type cut_quantile(cut_quantileSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< std::string >::type dedup(dedupSEXP);
+    Rcpp::traits::input_parameter< std::string >::type tile_path(tile_pathSEXP);
+    Rcpp::traits::input_parameter< double >::type memory_mb(memory_mbSEXP);
+    Rcpp::traits::input_parameter< std::string >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< bool >::type dimnames(dimnamesSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityNW(sequences, matrixName, gapOpen, gapExt, sparse, threshold, top_k, threads, engine, band, cutoff, cut_quantile, profile, dedup, tile_path, memory_mb, type, packed, dimnames));
+    return rcpp_result_gen;
+END_RCPP
+}
+// queryStore
+DataFrame queryStore(CharacterVector queries, std::string path, int top_k, double threshold, Rcpp::Nullable<Rcpp::CharacterVector> sequences, int candidates, std::string matrixName, int gapOpen, int gapExt, int band, int threads);
+RcppExport SEXP _DynaAlign_queryStore(SEXP queriesSEXP, SEXP pathSEXP, SEXP top_kSEXP, SEXP thresholdSEXP, SEXP sequencesSEXP, SEXP candidatesSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP, SEXP bandSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type queries(queriesSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< int >::type candidates(candidatesSEXP);
+    Rcpp::traits::input_parameter< std::string >::type matrixName(matrixNameSEXP);
+    Rcpp::traits::input_parameter< int >::type gapOpen(gapOpenSEXP);
+    Rcpp::traits::input_parameter< int >::type gapExt(gapExtSEXP);
+    Rcpp::traits::input_parameter< int >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(queryStore(queries, path, top_k, threshold, sequences, candidates, matrixName, gapOpen, gapExt, band, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// createSignatureStore
+List createSignatureStore(CharacterVector sequences, std::string path, int k, int n_hash, std::string method, int bits, int seed);
+RcppExport SEXP _DynaAlign_createSignatureStore(SEXP sequencesSEXP, SEXP pathSEXP, SEXP kSEXP, SEXP n_hashSEXP, SEXP methodSEXP, SEXP bitsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(createSignatureStore(sequences, path, k, n_hash, method, bits, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// createSignatureStores
+List createSignatureStores(CharacterVector sequences, CharacterVector paths, IntegerVector k, int n_hash, std::string method, int bits, int seed);
+RcppExport SEXP _DynaAlign_createSignatureStores(SEXP sequencesSEXP, SEXP pathsSEXP, SEXP kSEXP, SEXP n_hashSEXP, SEXP methodSEXP, SEXP bitsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(createSignatureStores(sequences, paths, k, n_hash, method, bits, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// appendSignatureStore
+List appendSignatureStore(CharacterVector sequences, std::string path);
+RcppExport SEXP _DynaAlign_appendSignatureStore(SEXP sequencesSEXP, SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(appendSignatureStore(sequences, path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// signatureStoreInfo
+List signatureStoreInfo(std::string path);
+RcppExport SEXP _DynaAlign_signatureStoreInfo(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(signatureStoreInfo(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// similarityStore
+SEXP similarityStore(std::string path, Rcpp::Nullable<Rcpp::IntegerVector> rows, bool sparse, double threshold, int top_k, double cut_quantile, bool profile, int n_hash);
+RcppExport SEXP _DynaAlign_similarityStore(SEXP pathSEXP, SEXP rowsSEXP, SEXP sparseSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP cut_quantileSEXP, SEXP profileSEXP, SEXP n_hashSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::IntegerVector> >::type rows(rowsSEXP);
+    Rcpp::traits::input_parameter< bool >::type sparse(sparseSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< double >::type cut_quantile(cut_quantileSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityStore(path, rows, sparse, threshold, top_k, cut_quantile, profile, n_hash));
+    return rcpp_result_gen;
+END_RCPP
+}
+// similarityHybrid
+DataFrame similarityHybrid(CharacterVector sequences, double mh_cutoff, int k, int n_hash, std::string method, std::string matrixName, int gapOpen, int gapExt, double threshold, int top_k, int band, int threads, int rows, int max_bucket, int seed);
+RcppExport SEXP _DynaAlign_similarityHybrid(SEXP sequencesSEXP, SEXP mh_cutoffSEXP, SEXP kSEXP, SEXP n_hashSEXP, SEXP methodSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP bandSEXP, SEXP threadsSEXP, SEXP rowsSEXP, SEXP max_bucketSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< double >::type mh_cutoff(mh_cutoffSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< std::string >::type matrixName(matrixNameSEXP);
+    Rcpp::traits::input_parameter< int >::type gapOpen(gapOpenSEXP);
+    Rcpp::traits::input_parameter< int >::type gapExt(gapExtSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< int >::type rows(rowsSEXP);
+    Rcpp::traits::input_parameter< int >::type max_bucket(max_bucketSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityHybrid(sequences, mh_cutoff, k, n_hash, method, matrixName, gapOpen, gapExt, threshold, top_k, band, threads, rows, max_bucket, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// similarityNWJob
+SEXP similarityNWJob(CharacterVector sequences, std::string matrixName, int gapOpen, int gapExt, bool sparse, double threshold, int top_k, int threads, std::string engine, int band, double cutoff, bool packed, bool dimnames);
+RcppExport SEXP _DynaAlign_similarityNWJob(SEXP sequencesSEXP, SEXP matrixNameSEXP, SEXP gapOpenSEXP, SEXP gapExtSEXP, SEXP sparseSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP threadsSEXP, SEXP engineSEXP, SEXP bandSEXP, SEXP cutoffSEXP, SEXP packedSEXP, SEXP dimnamesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< std::string >::type matrixName(matrixNameSEXP);
+    Rcpp::traits::input_parameter< int >::type gapOpen(gapOpenSEXP);
+    Rcpp::traits::input_parameter< int >::type gapExt(gapExtSEXP);
+    Rcpp::traits::input_parameter< bool >::type sparse(sparseSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type engine(engineSEXP);
+    Rcpp::traits::input_parameter< int >::type band(bandSEXP);
+    Rcpp::traits::input_parameter< double >::type cutoff(cutoffSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< bool >::type dimnames(dimnamesSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityNWJob(sequences, matrixName, gapOpen, gapExt, sparse, threshold, top_k, threads, engine, band, cutoff, packed, dimnames));
+    return rcpp_result_gen;
+END_RCPP
+}
+// similarityMHJob
+SEXP similarityMHJob(CharacterVector sequences, int k, int n_hash, std::string method, int bits, bool sparse, double threshold, int top_k, int threads, int seed, bool packed, bool dimnames);
+RcppExport SEXP _DynaAlign_similarityMHJob(SEXP sequencesSEXP, SEXP kSEXP, SEXP n_hashSEXP, SEXP methodSEXP, SEXP bitsSEXP, SEXP sparseSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP threadsSEXP, SEXP seedSEXP, SEXP packedSEXP, SEXP dimnamesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type sequences(sequencesSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type n_hash(n_hashSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< bool >::type sparse(sparseSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    Rcpp::traits::input_parameter< bool >::type dimnames(dimnamesSEXP);
+    rcpp_result_gen = Rcpp::wrap(similarityMHJob(sequences, k, n_hash, method, bits, sparse, threshold, top_k, threads, seed, packed, dimnames));
+    return rcpp_result_gen;
+END_RCPP
+}
+// jobStatus
+List jobStatus(SEXP job);
+RcppExport SEXP _DynaAlign_jobStatus(SEXP jobSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    rcpp_result_gen = Rcpp::wrap(jobStatus(job));
+    return rcpp_result_gen;
+END_RCPP
+}
+// jobCancel
+bool jobCancel(SEXP job);
+RcppExport SEXP _DynaAlign_jobCancel(SEXP jobSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    rcpp_result_gen = Rcpp::wrap(jobCancel(job));
+    return rcpp_result_gen;
+END_RCPP
+}
+// jobResult
+SEXP jobResult(SEXP job, bool wait);
+RcppExport SEXP _DynaAlign_jobResult(SEXP jobSEXP, SEXP waitSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    Rcpp::traits::input_parameter< bool >::type wait(waitSEXP);
+    rcpp_result_gen = Rcpp::wrap(jobResult(job, wait));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tileStoreInfo
+List tileStoreInfo(std::string path);
+RcppExport SEXP _DynaAlign_tileStoreInfo(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(tileStoreInfo(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// readTileStore
+DataFrame readTileStore(std::string path, double threshold, int top_k, double cut_quantile);
+RcppExport SEXP _DynaAlign_readTileStore(SEXP pathSEXP, SEXP thresholdSEXP, SEXP top_kSEXP, SEXP cut_quantileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< double >::type cut_quantile(cut_quantileSEXP);
+    rcpp_result_gen = Rcpp::wrap(readTileStore(path, threshold, top_k, cut_quantile));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_DynaAlign_similarityMH", (DL_FUNC) &_DynaAlign_similarityMH, 3},
-    {"_DynaAlign_similarityNW", (DL_FUNC) &_DynaAlign_similarityNW, 4},
+    {"_DynaAlign_benchmarkKernels", (DL_FUNC) &_DynaAlign_benchmarkKernels, 12},
+    {"_DynaAlign_clusterbreakNative", (DL_FUNC) &_DynaAlign_clusterbreakNative, 11},
+    {"_DynaAlign_clusterLouvain", (DL_FUNC) &_DynaAlign_clusterLouvain, 7},
+    {"_DynaAlign_consensusSequences", (DL_FUNC) &_DynaAlign_consensusSequences, 6},
+    {"_DynaAlign_collapseDuplicates", (DL_FUNC) &_DynaAlign_collapseDuplicates, 1},
+    {"_DynaAlign_similarityMH", (DL_FUNC) &_DynaAlign_similarityMH, 16},
+    {"_DynaAlign_similarityLSH", (DL_FUNC) &_DynaAlign_similarityLSH, 10},
+    {"_DynaAlign_similarityNW", (DL_FUNC) &_DynaAlign_similarityNW, 19},
+    {"_DynaAlign_queryStore", (DL_FUNC) &_DynaAlign_queryStore, 11},
+    {"_DynaAlign_createSignatureStore", (DL_FUNC) &_DynaAlign_createSignatureStore, 7},
+    {"_DynaAlign_createSignatureStores", (DL_FUNC) &_DynaAlign_createSignatureStores, 7},
+    {"_DynaAlign_appendSignatureStore", (DL_FUNC) &_DynaAlign_appendSignatureStore, 2},
+    {"_DynaAlign_signatureStoreInfo", (DL_FUNC) &_DynaAlign_signatureStoreInfo, 1},
+    {"_DynaAlign_similarityStore", (DL_FUNC) &_DynaAlign_similarityStore, 8},
+    {"_DynaAlign_similarityHybrid", (DL_FUNC) &_DynaAlign_similarityHybrid, 15},
+    {"_DynaAlign_similarityNWJob", (DL_FUNC) &_DynaAlign_similarityNWJob, 13},
+    {"_DynaAlign_similarityMHJob", (DL_FUNC) &_DynaAlign_similarityMHJob, 12},
+    {"_DynaAlign_jobStatus", (DL_FUNC) &_DynaAlign_jobStatus, 1},
+    {"_DynaAlign_jobCancel", (DL_FUNC) &_DynaAlign_jobCancel, 1},
+    {"_DynaAlign_jobResult", (DL_FUNC) &_DynaAlign_jobResult, 2},
+    {"_DynaAlign_tileStoreInfo", (DL_FUNC) &_DynaAlign_tileStoreInfo, 1},
+    {"_DynaAlign_readTileStore", (DL_FUNC) &_DynaAlign_readTileStore, 4},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,135 @@
+#ifndef ALPHABET_HPP
+#define ALPHABET_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compact residue alphabet shared by the sequence kernels.
+//
+// The 24 symbols of the substitution matrices keep their row order
+// (A R N D C Q E G H I L K M F P S T W Y V B Z X *), the remaining letters
+// J O U follow, and every other byte maps to UNKNOWN_RESIDUE. Lowercase
+// letters share the code of their uppercase form. All codes fit in 5 bits.
+const int ALPHABET_SIZE = 24;
+const int RESIDUE_BITS = 5;
+const uint8_t UNKNOWN_RESIDUE = 31;
+
+// Symbols in code order; stored with persisted signatures so that a change
+// of encoding is detected
+const char* const RESIDUE_SYMBOLS = "ARNDCQEGHILKMFPSTWYVBZX*JOU";
+
+struct ResidueCodes {
+  uint8_t code[256];
+
+  ResidueCodes() {
+    const char* symbols = RESIDUE_SYMBOLS;
+    for (int c = 0; c < 256; ++c) {
+      code[c] = UNKNOWN_RESIDUE;
+    }
+    for (int r = 0; symbols[r] != '\0'; ++r) {
+      unsigned char upper = static_cast<unsigned char>(symbols[r]);
+      code[upper] = static_cast<uint8_t>(r);
+      if (upper >= 'A' && upper <= 'Z') {
+        code[upper - 'A' + 'a'] = static_cast<uint8_t>(r);
+      }
+    }
+  }
+};
+
+inline const ResidueCodes& residue_codes() {
+  static const ResidueCodes table;
+  return table;
+}
+
+inline uint8_t encode_residue(char c) {
+  return residue_codes().code[static_cast<unsigned char>(c)];
+}
+
+// Call f(code) with a 64-bit integer identifying each k-mer of `seq`, rolling
+// the code across the sequence without allocating. Up to 12 residues are
+// packed exactly (5 bits each); longer k-mers use a Rabin-Karp rolling hash.
+template <typename F>
+inline void for_each_kmer(const std::string& seq, int k, F f) {
+  size_t len = seq.length();
+  if (k <= 0 || len < static_cast<size_t>(k)) {
+    return;
+  }
+
+  if (k * RESIDUE_BITS <= 64) {
+    const uint64_t mask = (1ULL << (k * RESIDUE_BITS)) - 1;
+    uint64_t code = 0;
+    for (size_t i = 0; i < len; ++i) {
+      code = ((code << RESIDUE_BITS) | encode_residue(seq[i])) & mask;
+      if (i + 1 >= static_cast<size_t>(k)) {
+        f(code);
+      }
+    }
+  } else {
+    const uint64_t base = 0x100000001b3ULL;
+    uint64_t drop = 1;  // base^(k-1), weight of the residue leaving the window
+    for (int i = 1; i < k; ++i) {
+      drop *= base;
+    }
+    uint64_t code = 0;
+    for (size_t i = 0; i < len; ++i) {
+      if (i >= static_cast<size_t>(k)) {
+        code -= drop * (encode_residue(seq[i - k]) + 1);
+      }
+      code = code * base + (encode_residue(seq[i]) + 1);
+      if (i + 1 >= static_cast<size_t>(k)) {
+        f(code);
+      }
+    }
+  }
+}
+
+// Call f(index, start, code) for every k-mer of each length ks[index] in one
+// pass over `seq`, where `start` is the position of the k-mer's first residue
+// and `code` equals the one for_each_kmer() gives for that length. Short
+// lengths share one packed code of the last 12 residues, masked per length;
+// longer ones keep their own rolling hashes.
+template <typename F>
+inline void for_each_kmer_lengths(const std::string& seq, const std::vector<int>& ks, F f) {
+  const int PACKED_MAX = 64 / RESIDUE_BITS;  // same limit as for_each_kmer()
+  size_t n_lengths = ks.size();
+  std::vector<uint64_t> masks(n_lengths, 0);
+  std::vector<uint64_t> rolling(n_lengths, 0);
+  std::vector<uint64_t> drops(n_lengths, 1);
+  const uint64_t base = 0x100000001b3ULL;
+  for (size_t index = 0; index < n_lengths; ++index) {
+    if (ks[index] <= PACKED_MAX) {
+      masks[index] = (1ULL << (ks[index] * RESIDUE_BITS)) - 1;
+    }
+    for (int i = 1; i < ks[index]; ++i) {
+      drops[index] *= base;
+    }
+  }
+
+  uint64_t packed = 0;
+  for (size_t i = 0; i < seq.length(); ++i) {
+    uint8_t residue = encode_residue(seq[i]);
+    packed = (packed << RESIDUE_BITS) | residue;
+    for (size_t index = 0; index < n_lengths; ++index) {
+      size_t k = static_cast<size_t>(ks[index]);
+      if (ks[index] <= 0) {
+        continue;
+      }
+      uint64_t code;
+      if (masks[index] != 0) {
+        code = packed & masks[index];
+      } else {
+        if (i >= k) {
+          rolling[index] -= drops[index] * (encode_residue(seq[i - k]) + 1);
+        }
+        rolling[index] = rolling[index] * base + (residue + 1);
+        code = rolling[index];
+      }
+      if (i + 1 >= k) {
+        f(index, i + 1 - k, code);
+      }
+    }
+  }
+}
+
+#endif // ALPHABET_HPP
@@ -0,0 +1,267 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "minHash.hpp"
+#include "needlemanWunsch.hpp"
+#include "packedSignatures.hpp"
+#include "pairScheduler.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// Peak resident set size of the process in MiB so far (NA where unknown)
+static double peak_rss_mb() {
+#ifdef _WIN32
+  return NA_REAL;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return NA_REAL;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+  return usage.ru_maxrss / 1024.0;  // KiB
+#endif
+#endif
+}
+
+// Doubles per cache line
+static const int PAD = 8;
+
+// Median wall time in seconds of `reps` calls of run(), which returns a
+// checksum of its results so that the work cannot be optimised away
+template <typename F>
+static double time_median(int reps, F run, double& checksum) {
+  vector<double> seconds(reps);
+  for (int r = 0; r < reps; ++r) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    checksum = run();
+    seconds[r] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    Rcpp::checkUserInterrupt();
+  }
+  sort(seconds.begin(), seconds.end());
+  return reps % 2 == 1 ? seconds[reps / 2] : (seconds[reps / 2 - 1] + seconds[reps / 2]) / 2;
+}
+
+//' @name benchmarkKernels
+//' @title Benchmark the Similarity Kernels
+//'
+//' @description
+//' Times the kernels behind [similarityMH()] and [similarityNW()] on
+//' `sequences` at each thread count, without the cost of building the R
+//' result, so that engines and builds can be compared and regressions
+//' caught. The MinHash signature and comparison phases are timed
+//' separately; alignments are timed with both the scalar and the vectorized
+//' engine. Each measurement is the median of `reps` runs.
+//'
+//' @param sequences A character vector of input sequences
+//' @param threads Thread counts to run each kernel with (default: NULL,
+//'        powers of two up to all available cores)
+//' @param kernels Kernels to time, any of `"mh_sketch"`, `"mh_compare"`,
+//'        `"nw_scalar"` and `"nw_simd"` (default: all)
+//' @param reps Number of timed runs per measurement (default: 3)
+//' @param k The length of k-mers for MinHash (default: 4)
+//' @param n_hash Number of hash functions for MinHash (default: 50)
+//' @param method Sketch method, as in [similarityMH()] (default: "mix")
+//' @param bits Bits per signature slot, as in [similarityMH()] (default: 32)
+//' @param matrixName Substitution matrix for alignments (default: "BLOSUM62")
+//' @param gapOpen Penalty for opening a gap (default: 10)
+//' @param gapExt Penalty for extending a gap (default: 4)
+//' @param band Banded alignment width for `"nw_scalar"`, see
+//'        [similarityNW()] (default: -1, none)
+//' @return A data frame with one row per kernel and thread count:
+//'   \item{kernel, threads}{What was timed}
+//'   \item{seconds}{Median wall time of one run}
+//'   \item{items, items_per_sec}{Sequences sketched (`"mh_sketch"`) or pairs
+//'         compared, and their throughput}
+//'   \item{gcups}{Billions of DP cells updated per second for alignments
+//'         (NA for MinHash)}
+//'   \item{speedup, efficiency}{Speedup over the smallest thread count of
+//'         the same kernel, and that speedup divided by the increase in
+//'         threads}
+//'   \item{peak_rss_mb}{Peak resident memory of the R process so far, in
+//'         MiB (NA on Windows)}
+//'   \item{checksum}{Sum of the scores (or matching slots), equal across
+//'         thread counts and, without `band`, between the two alignment
+//'         engines}
+//' @export
+// [[Rcpp::export]]
+DataFrame benchmarkKernels(CharacterVector sequences,
+                           Rcpp::Nullable<Rcpp::IntegerVector> threads = R_NilValue,
+                           CharacterVector kernels = CharacterVector::create("mh_sketch", "mh_compare",
+                                                                             "nw_scalar", "nw_simd"),
+                           int reps = 3, int k = 4, int n_hash = 50, std::string method = "mix",
+                           int bits = 32, std::string matrixName = "BLOSUM62", int gapOpen = 10,
+                           int gapExt = 4, int band = -1) {
+  if (sequences.length() < 2) {
+    Rcpp::stop("At least two sequences are needed");
+  }
+  if (reps <= 0) {
+    Rcpp::stop("'reps' must be a positive integer");
+  }
+  if (k <= 0) {
+    Rcpp::stop("'k' must be a positive integer");
+  }
+  if (n_hash <= 0) {
+    Rcpp::stop("Number of hash functions must be positive");
+  }
+  if (!valid_signature_bits(bits)) {
+    Rcpp::stop("'bits' must be one of 1, 2, 4, 8, 16 or 32");
+  }
+  if (band < -1) {
+    Rcpp::stop("'band' must be -1 (no band), 0 (automatic) or a positive width");
+  }
+  vector<string> names = as<vector<string>>(kernels);
+  for (const string& name : names) {
+    if (name != "mh_sketch" && name != "mh_compare" && name != "nw_scalar" && name != "nw_simd") {
+      Rcpp::stop("Invalid kernel: %s", name);
+    }
+  }
+
+  // Thread counts, smallest first
+  vector<int> counts;
+  if (threads.isNull()) {
+    for (int t = 1; t < max_threads(); t *= 2) {
+      counts.push_back(t);
+    }
+    counts.push_back(max_threads());
+  } else {
+    IntegerVector given(threads.get());
+    for (R_xlen_t t = 0; t < given.length(); ++t) {
+      if (given[t] == NA_INTEGER) {
+        Rcpp::stop("'threads' must be non-negative integers");
+      }
+      counts.push_back(resolve_threads(given[t]));
+    }
+    sort(counts.begin(), counts.end());
+    counts.erase(unique(counts.begin(), counts.end()), counts.end());
+  }
+  if (counts.empty()) {
+    Rcpp::stop("'threads' must contain at least one value");
+  }
+
+  // Inputs shared by all runs
+  vector<string> seqs = as<vector<string>>(sequences);
+  size_t n = seqs.size();
+  double n_pairs = static_cast<double>(n) * (n - 1) / 2;
+  MinHasher hasher(k, n_hash, parse_sketch_method(method), 42);
+  PackedSignatures signatures = compute_signatures(seqs, hasher, bits);
+  size_t tile = signature_tile_rows(signatures);
+
+  const int (*substitutionMatrix)[24] = getSubstitutionMatrix(matrixName);
+  vector<vector<uint8_t>> encoded = encode_sequences(seqs);
+  vector<size_t> lengths(n);
+  double total_length = 0.0, squared_length = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    lengths[i] = encoded[i].size();
+    total_length += lengths[i];
+    squared_length += static_cast<double>(lengths[i]) * lengths[i];
+  }
+  double n_cells = (total_length * total_length - squared_length) / 2;  // sum of m * n over pairs
+  int lanes = 0;
+  NWBatchKernel simd_kernel = select_nw_batch_kernel(lanes);
+  bool simd_ok = simd_kernel != 0 && is_symmetric(substitutionMatrix);
+
+  vector<string> col_kernel;
+  vector<int> col_threads;
+  vector<double> col_seconds, col_items, col_rate, col_gcups, col_speedup, col_efficiency,
+    col_rss, col_checksum;
+
+  for (const string& name : names) {
+    if (name == "nw_simd" && !simd_ok) {
+      Rcpp::warning("The vectorized engine is not available for this build or matrix; "
+                    "skipping \"nw_simd\"");
+      continue;
+    }
+    double base_seconds = 0.0;
+    for (size_t c = 0; c < counts.size(); ++c) {
+      int n_threads = counts[c];
+      // Per-thread sums a cache line apart, so that threads do not contend
+      vector<double> sums(n_threads * PAD);
+      auto reset = [&]() { fill(sums.begin(), sums.end(), 0.0); };
+      auto total = [&]() {
+        double sum = 0.0;
+        for (int t = 0; t < n_threads; ++t) {
+          sum += sums[t * PAD];
+        }
+        return sum;
+      };
+      double checksum = 0.0, seconds = 0.0, items = n_pairs;
+
+      if (name == "mh_sketch") {
+        items = static_cast<double>(n);
+        seconds = time_median(reps, [&]() {
+          PackedSignatures sketched = compute_signatures(seqs, hasher, bits, n_threads);
+          return static_cast<double>(sketched.matches(0, 1));
+        }, checksum);
+      } else if (name == "mh_compare") {
+        seconds = time_median(reps, [&]() {
+          reset();
+          for_each_pair_tiled(n, tile, [&](size_t i, size_t j) {
+            sums[current_thread() * PAD] += signatures.matches(i, j);
+          }, n_threads);
+          return total();
+        }, checksum);
+      } else if (name == "nw_scalar") {
+        vector<NWWorkspace> workspaces(n_threads);
+        seconds = time_median(reps, [&]() {
+          reset();
+          for_each_pair_balanced(lengths, n_threads, [&](size_t i, size_t j, int thread) {
+            sums[thread * PAD] += calculate_similarity(encoded[i], encoded[j], substitutionMatrix,
+                                                 gapOpen, gapExt, workspaces[thread], band);
+          });
+          return total();
+        }, checksum);
+      } else {
+        seconds = time_median(reps, [&]() {
+          reset();
+          for_each_pair_simd(encoded, substitutionMatrix, gapOpen, gapExt, n_threads,
+                             simd_kernel, lanes, [&](size_t, size_t, double similarity) {
+            sums[current_thread() * PAD] += similarity;
+          });
+          return total();
+        }, checksum);
+      }
+
+      if (c == 0) {
+        base_seconds = seconds;
+      }
+      double speedup = seconds > 0.0 ? base_seconds / seconds : NA_REAL;
+      bool alignment = name == "nw_scalar" || name == "nw_simd";
+      col_kernel.push_back(name);
+      col_threads.push_back(n_threads);
+      col_seconds.push_back(seconds);
+      col_items.push_back(items);
+      col_rate.push_back(seconds > 0.0 ? items / seconds : NA_REAL);
+      col_gcups.push_back(alignment && seconds > 0.0 ? n_cells / seconds / 1e9 : NA_REAL);
+      col_speedup.push_back(speedup);
+      col_efficiency.push_back(speedup * counts[0] / n_threads);
+      col_rss.push_back(peak_rss_mb());
+      col_checksum.push_back(checksum);
+    }
+  }
+
+  return DataFrame::create(Named("kernel") = wrap(col_kernel),
+                           Named("threads") = wrap(col_threads),
+                           Named("seconds") = wrap(col_seconds),
+                           Named("items") = wrap(col_items),
+                           Named("items_per_sec") = wrap(col_rate),
+                           Named("gcups") = wrap(col_gcups),
+                           Named("speedup") = wrap(col_speedup),
+                           Named("efficiency") = wrap(col_efficiency),
+                           Named("peak_rss_mb") = wrap(col_rss),
+                           Named("checksum") = wrap(col_checksum));
+}
@@ -0,0 +1,113 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "clusterBreak.hpp"
+#include "minHash.hpp"
+#include "signatureStore.hpp"
+#include "pairScheduler.hpp"
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+//' @name clusterbreakNative
+//' @title Native Recursive Cluster Splitting
+//'
+//' @description
+//' The recursion of [clusterbreak()] in native code, used by
+//' `clusterbreak(native = TRUE)`. Every call compares the MinHash signatures
+//' of its sequences, keeps the pairs at or above the `thresh_p` quantile of
+//' their similarities, clusters the resulting graph as [clusterLouvain()]
+//' does (Leiden refinement, `restarts` runs, best modularity) and splits the
+//' clusters larger than `size_max` again. Sibling clusters are split as
+//' parallel tasks, and large calls compare their pairs in parallel too.
+//'
+//' Calls are numbered afterwards in the order the R recursion makes them,
+//' so the labels and row order match
+//' `clusterbreak(pep, cluster_fn = NULL, signatures = TRUE)`, independent of
+//' the number of threads.
+//'
+//' @param sequences A character vector of amino acid sequences
+//' @param thresh_p Quantile of the pair similarities used as the edge
+//'        threshold (default: 0.8)
+//' @param size_max Clusters above this size are split again (default: 10)
+//' @param size_min Clusters below this size are filtered out (default: 3)
+//' @param max_itr Maximum number of calls (default: 10000)
+//' @param weighted If `FALSE`, every kept pair is an edge of weight 1
+//'        (default: TRUE)
+//' @param signatures Optional signature store of `sequences` created by
+//'        [createSignatureStore()]; by default the sequences are sketched
+//'        with `k = 2`, `n_hash = 50` and seed 42 (default: "")
+//' @param resolution Resolution of the clustering (default: 1.05)
+//' @param restarts Number of randomised clustering runs per call
+//'        (default: 10)
+//' @param seed Seed of the clustering runs (default: 42)
+//' @param threads Number of threads (default: 0, all available cores)
+//' @return A list containing:
+//'   \item{clustered_seq}{A n x 2 character matrix of the clustered sequences
+//'         and their `"iteration.cluster"` labels}
+//'   \item{filtered_seq}{Sequences of the clusters below `size_min`}
+//'   \item{iterations}{Number of calls made}
+//'   \item{converged}{`FALSE` if `max_itr` was reached}
+//' @export
+// [[Rcpp::export]]
+List clusterbreakNative(CharacterVector sequences, double thresh_p = 0.8, int size_max = 10,
+                        int size_min = 3, int max_itr = 10000, bool weighted = true,
+                        std::string signatures = "", double resolution = 1.05,
+                        int restarts = 10, int seed = 42, int threads = 0) {
+  if (size_max <= size_min) {
+    Rcpp::stop("size_max must be greater than size_min");
+  }
+  if (sequences.length() == 0) {
+    Rcpp::stop("empty input sequence vector");
+  }
+  if (!(thresh_p >= 0.0 && thresh_p <= 1.0)) {
+    Rcpp::stop("'thresh_p' must be between 0 and 1");
+  }
+  if (!(resolution > 0.0)) {
+    Rcpp::stop("'resolution' must be positive");
+  }
+  if (restarts <= 0) {
+    Rcpp::stop("'restarts' must be a positive integer");
+  }
+  int n_threads = resolve_threads(threads);
+  vector<string> seqs = as<vector<string>>(sequences);
+
+  BreakParams params;
+  params.thresh_p = thresh_p;
+  params.size_max = static_cast<size_t>(max(size_max, 0));
+  params.size_min = static_cast<size_t>(max(size_min, 0));
+  params.max_itr = max_itr;
+  params.weighted = weighted;
+  params.resolution = resolution;
+  params.restarts = restarts;
+  params.seed = seed;
+
+  BreakResult result;
+  if (signatures.empty()) {
+    MinHasher hasher(2, 50, SKETCH_MIX, 42);
+    result = cluster_break(compute_signatures(seqs, hasher, 32, n_threads), params, n_threads);
+  } else {
+    SignatureStore store(signatures);
+    if (store.header().n != seqs.size()) {
+      Rcpp::stop("signature store must hold one signature per sequence of pep");
+    }
+    result = cluster_break(store.signatures(), params, n_threads);
+  }
+
+  size_t n_clustered = result.clustered.size();
+  CharacterMatrix clustered(static_cast<int>(n_clustered), 2);
+  for (size_t r = 0; r < n_clustered; ++r) {
+    clustered(r, 0) = sequences[result.clustered[r]];
+    clustered(r, 1) = to_string(result.iteration[r]) + "." + to_string(result.cluster[r]);
+  }
+  colnames(clustered) = CharacterVector::create("pep", "c.index");
+  CharacterVector filtered(result.filtered.size());
+  for (size_t r = 0; r < result.filtered.size(); ++r) {
+    filtered[r] = sequences[result.filtered[r]];
+  }
+  return List::create(Named("clustered_seq") = clustered,
+                      Named("filtered_seq") = filtered,
+                      Named("iterations") = static_cast<double>(result.iterations),
+                      Named("converged") = result.converged);
+}
@@ -0,0 +1,296 @@
+#ifndef CLUSTER_BREAK_HPP
+#define CLUSTER_BREAK_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <limits>
+#include <cstdint>
+#include "packedSignatures.hpp"
+#include "scoreDistribution.hpp"
+#include "communityDetection.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// Parameters of the clusterbreak recursion
+struct BreakParams {
+  double thresh_p;    // quantile of the pair similarities kept as edges
+  size_t size_max;    // clusters above it are split again
+  size_t size_min;    // clusters below it are filtered out
+  long max_itr;       // calls numbered above it do nothing
+  bool weighted;      // similarities as edge weights, or weight 1
+  double resolution;
+  int restarts;
+  int seed;
+};
+
+// Rows per task of the pairwise comparisons; nodes with fewer members are
+// compared by the task that processes them
+const size_t BREAK_BLOCK_ROWS = 64;
+
+// One call of the recursion: the members it clusters and, once processed,
+// the 1-based cluster of each member and one child per oversized cluster
+struct BreakNode {
+  vector<size_t> members;
+  bool processed = false;
+  vector<int> cluster;
+  vector<size_t> sizes;  // sizes[c] members in cluster c (1-based)
+  vector<unique_ptr<BreakNode>> children;
+
+  bool filtered(size_t m, const BreakParams& params) const {
+    return sizes[cluster[m]] < params.size_min;
+  }
+
+  bool split(size_t m, const BreakParams& params) const {
+    return sizes[cluster[m]] > params.size_max;
+  }
+};
+
+// Flattened result: clustered rows in the order the R recursion appends
+// them, labelled by the number of the call that produced them
+struct BreakResult {
+  vector<size_t> clustered;
+  vector<long> iteration;
+  vector<int> cluster;
+  vector<size_t> filtered;
+  long iterations = 0;
+  bool converged = true;
+};
+
+// Edges of the similarity graph of `members`: the pairs whose MinHash
+// similarity is at least the thresh_p quantile of all their pairs (the cut
+// similarityStore(cut_quantile = thresh_p) applies) and above zero. Blocks
+// of rows run as tasks, so a large node uses every thread of the team.
+inline vector<GraphEdge> break_edges(const PackedSignatures& signatures,
+                                     const vector<size_t>& members, const BreakParams& params) {
+  size_t n = members.size();
+  int n_hash = signatures.num_hash();
+  size_t n_blocks = (n + BREAK_BLOCK_ROWS - 1) / BREAK_BLOCK_ROWS;
+  bool deferred = n_blocks > 1;
+
+  // Pairs by number of agreeing slots
+  vector<vector<uint64_t>> tallies(n_blocks, vector<uint64_t>(n_hash + 1, 0));
+  for (size_t b = 0; b < n_blocks; ++b) {
+#ifdef _OPENMP
+#pragma omp task default(shared) firstprivate(b) if(deferred)
+#endif
+    {
+      size_t end = min(n, (b + 1) * BREAK_BLOCK_ROWS);
+      for (size_t i = b * BREAK_BLOCK_ROWS; i < end; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+          ++tallies[b][signatures.matches(members[i], members[j])];
+        }
+      }
+    }
+  }
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+  ScoreCounts counts;
+  for (int agree = 0; agree <= n_hash; ++agree) {
+    uint64_t count = 0;
+    for (size_t b = 0; b < n_blocks; ++b) {
+      count += tallies[b][agree];
+    }
+    if (count > 0) {
+      counts.push_back(make_pair(signatures.similarity_of(agree), count));
+    }
+  }
+  double q = score_quantile(counts, params.thresh_p);
+  int min_agree = 0;
+  if (q == q) {
+    while (min_agree <= n_hash && signatures.similarity_of(min_agree) < q) {
+      ++min_agree;
+    }
+  }
+
+  vector<vector<GraphEdge>> blocks(n_blocks);
+  for (size_t b = 0; b < n_blocks; ++b) {
+#ifdef _OPENMP
+#pragma omp task default(shared) firstprivate(b) if(deferred)
+#endif
+    {
+      size_t end = min(n, (b + 1) * BREAK_BLOCK_ROWS);
+      for (size_t i = b * BREAK_BLOCK_ROWS; i < end; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+          int agree = signatures.matches(members[i], members[j]);
+          double score = signatures.similarity_of(agree);
+          if (agree >= min_agree && score > 0.0) {
+            GraphEdge edge = {static_cast<int>(i), static_cast<int>(j),
+                              params.weighted ? score : 1.0};
+            blocks[b].push_back(edge);
+          }
+        }
+      }
+    }
+  }
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+  vector<GraphEdge> edges;
+  for (size_t b = 0; b < n_blocks; ++b) {
+    edges.insert(edges.end(), blocks[b].begin(), blocks[b].end());
+  }
+  return edges;
+}
+
+// Best of params.restarts Leiden runs, each a task, chosen as
+// clusterLouvain() chooses: highest modularity, ties to the lower restart
+inline vector<int> break_partition(const WeightedGraph& graph, const BreakParams& params) {
+  size_t restarts = static_cast<size_t>(params.restarts);
+  vector<vector<int>> runs(restarts);
+  vector<double> modularity(restarts);
+  for (size_t run = 0; run < restarts; ++run) {
+#ifdef _OPENMP
+#pragma omp task default(shared) firstprivate(run)
+#endif
+    {
+      CommunityDetector detector(params.resolution, true, restart_seed(params.seed, run));
+      runs[run] = detector.run(graph);
+      double q = graph_modularity(graph, runs[run], 1.0);
+      modularity[run] = q != q ? -numeric_limits<double>::infinity() : q;
+    }
+  }
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+  size_t best = 0;
+  for (size_t run = 1; run < restarts; ++run) {
+    if (modularity[run] > modularity[best]) {
+      best = run;
+    }
+  }
+  return runs[best];
+}
+
+// Cluster the members of `node` and create a child for every cluster above
+// size_max, in order of first appearance, with its members in order
+inline void break_process(const PackedSignatures& signatures, const BreakParams& params,
+                          BreakNode& node) {
+  size_t n = node.members.size();
+  WeightedGraph graph = make_graph(static_cast<int>(n),
+                                   break_edges(signatures, node.members, params));
+  vector<int> membership = break_partition(graph, params);
+
+  node.cluster.resize(n);
+  node.sizes.assign(1, 0);
+  for (size_t m = 0; m < n; ++m) {
+    node.cluster[m] = membership[m] + 1;
+    if (node.sizes.size() <= static_cast<size_t>(node.cluster[m])) {
+      node.sizes.resize(node.cluster[m] + 1, 0);
+    }
+    ++node.sizes[node.cluster[m]];
+  }
+
+  vector<BreakNode*> child_of(node.sizes.size(), nullptr);
+  for (size_t m = 0; m < n; ++m) {
+    if (!node.split(m, params)) {
+      continue;
+    }
+    BreakNode*& child = child_of[node.cluster[m]];
+    if (!child) {
+      node.children.push_back(unique_ptr<BreakNode>(new BreakNode()));
+      child = node.children.back().get();
+    }
+    child->members.push_back(node.members[m]);
+  }
+  node.processed = true;
+}
+
+// Process `node` and then its children as tasks, while the shared budget of
+// calls lasts; nodes left unprocessed are finished on demand by
+// break_collect(), which only needs those numbered within max_itr
+inline void break_spawn(const PackedSignatures* signatures, const BreakParams* params,
+                        atomic<long>* budget, BreakNode* node) {
+  if (budget->fetch_sub(1) <= 0) {
+    return;
+  }
+  break_process(*signatures, *params, *node);
+  for (size_t c = 0; c < node->children.size(); ++c) {
+    BreakNode* child = node->children[c].get();
+#ifdef _OPENMP
+#pragma omp task firstprivate(signatures, params, budget, child)
+#endif
+    break_spawn(signatures, params, budget, child);
+  }
+}
+
+// Number the calls depth first, children in order, exactly as the R
+// recursion increments its counter, and gather the rows of the calls
+// numbered within max_itr into buffers sized up front
+inline BreakResult break_collect(const PackedSignatures& signatures, const BreakParams& params,
+                                 BreakNode& root) {
+  BreakResult result;
+  vector<pair<BreakNode*, long>> calls;
+  vector<BreakNode*> stack(1, &root);
+  size_t n_clustered = 0;
+  size_t n_filtered = 0;
+  while (!stack.empty()) {
+    BreakNode* node = stack.back();
+    stack.pop_back();
+    long number = ++result.iterations;
+    if (number > params.max_itr) {
+      result.converged = false;
+      continue;
+    }
+    if (!node->processed) {
+      break_process(signatures, params, *node);
+    }
+    calls.push_back(make_pair(node, number));
+    for (size_t m = 0; m < node->members.size(); ++m) {
+      if (node->filtered(m, params)) {
+        ++n_filtered;
+      } else if (!node->split(m, params)) {
+        ++n_clustered;
+      }
+    }
+    for (size_t c = node->children.size(); c > 0; --c) {
+      stack.push_back(node->children[c - 1].get());
+    }
+  }
+
+  result.clustered.reserve(n_clustered);
+  result.iteration.reserve(n_clustered);
+  result.cluster.reserve(n_clustered);
+  result.filtered.reserve(n_filtered);
+  for (const pair<BreakNode*, long>& call : calls) {
+    const BreakNode& node = *call.first;
+    for (size_t m = 0; m < node.members.size(); ++m) {
+      if (node.filtered(m, params)) {
+        result.filtered.push_back(node.members[m]);
+      } else if (!node.split(m, params)) {
+        result.clustered.push_back(node.members[m]);
+        result.iteration.push_back(call.second);
+        result.cluster.push_back(node.cluster[m]);
+      }
+    }
+  }
+  return result;
+}
+
+// The clusterbreak recursion over the sequences whose signatures are given:
+// cut at the thresh_p quantile, cluster, keep clusters within bounds, drop
+// small ones and split the rest again. Sibling clusters are split as
+// independent tasks of one thread team.
+inline BreakResult cluster_break(const PackedSignatures& signatures, const BreakParams& params,
+                                 int n_threads) {
+  BreakNode root;
+  root.members.resize(signatures.size());
+  for (size_t i = 0; i < root.members.size(); ++i) {
+    root.members[i] = i;
+  }
+  atomic<long> budget(params.max_itr);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#pragma omp single
+#endif
+  break_spawn(&signatures, &params, &budget, &root);
+  return break_collect(signatures, params, root);
+}
+
+#endif // CLUSTER_BREAK_HPP
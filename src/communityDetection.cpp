@@ -0,0 +1,160 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "communityDetection.hpp"
+#include "pairScheduler.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// Edges of a similarity matrix (upper triangle) or of a sparse_similarity
+// edge list; the number of nodes is returned in n
+static vector<GraphEdge> similarity_edges(SEXP similarity, bool weighted, int& n) {
+  vector<GraphEdge> edges;
+  if (Rf_inherits(similarity, "sparse_similarity")) {
+    DataFrame list(similarity);
+    IntegerVector i = list["i"];
+    IntegerVector j = list["j"];
+    NumericVector score = list["score"];
+    n = as<int>(list.attr("n"));
+    for (R_xlen_t e = 0; e < i.length(); ++e) {
+      if (i[e] < 1 || i[e] > n || j[e] < 1 || j[e] > n) {
+        Rcpp::stop("Edge %d refers to a node outside 1..%d", static_cast<int>(e + 1), n);
+      }
+      GraphEdge edge = {i[e] - 1, j[e] - 1, weighted ? score[e] : (score[e] > 0.0 ? 1.0 : 0.0)};
+      edges.push_back(edge);
+    }
+    return edges;
+  }
+
+  NumericMatrix matrix(similarity);
+  if (matrix.nrow() != matrix.ncol()) {
+    Rcpp::stop("Input must be a square pairwise similarity matrix");
+  }
+  n = matrix.nrow();
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < j; ++i) {
+      double w = matrix(i, j);
+      if (w > 0.0) {
+        GraphEdge edge = {i, j, weighted ? w : 1.0};
+        edges.push_back(edge);
+      }
+    }
+  }
+  return edges;
+}
+
+//' @name clusterLouvain
+//' @title Native Louvain/Leiden Clustering of a Similarity Graph
+//'
+//' @description
+//' Detects communities in the graph whose edge weights are the pairwise
+//' similarities, without building an igraph network. Nodes are moved between
+//' communities to maximise modularity and the graph is collapsed level by
+//' level, as in the Louvain method; with `refine = TRUE` every level also
+//' splits communities into well-connected subcommunities before collapsing
+//' (the Leiden algorithm), so that no community ends up disconnected.
+//'
+//' `restarts` randomised runs are made for every value of `resolution`, all
+//' in parallel, and the partition with the highest modularity is returned.
+//' Results depend only on `seed`, not on the number of threads.
+//'
+//' @param similarity A square similarity matrix (only its upper triangle
+//'        is read; the diagonal is ignored) or a `sparse_similarity` edge list
+//' @param resolution One or more resolution parameters; higher values give
+//'        more, smaller communities (default: 1)
+//' @param restarts Number of randomised runs per resolution (default: 10)
+//' @param refine If `TRUE`, use Leiden refinement; if `FALSE`, plain Louvain
+//'        (default: TRUE)
+//' @param weighted If `FALSE`, every positive similarity is an edge of
+//'        weight 1 (default: TRUE)
+//' @param seed Seed of the random node orders (default: 42)
+//' @param threads Number of threads (default: 0, all available cores)
+//' @return A list containing:
+//'   \item{membership}{Integer community of each node, numbered from 1}
+//'   \item{modularity}{Modularity of that partition (at resolution 1)}
+//'   \item{resolution}{Resolution of the run that produced it}
+//'   \item{sweep}{Data frame with the best modularity and number of
+//'         communities found at each resolution}
+//' @export
+// [[Rcpp::export]]
+List clusterLouvain(SEXP similarity, NumericVector resolution = NumericVector::create(1.0),
+                    int restarts = 10, bool refine = true, bool weighted = true,
+                    int seed = 42, int threads = 0) {
+  if (resolution.length() == 0) {
+    Rcpp::stop("'resolution' must contain at least one value");
+  }
+  for (R_xlen_t r = 0; r < resolution.length(); ++r) {
+    if (!(resolution[r] > 0.0)) {
+      Rcpp::stop("'resolution' values must be positive");
+    }
+  }
+  if (restarts <= 0) {
+    Rcpp::stop("'restarts' must be a positive integer");
+  }
+  int n_threads = resolve_threads(threads);
+
+  int n = 0;
+  vector<GraphEdge> edges = similarity_edges(similarity, weighted, n);
+  WeightedGraph graph = make_graph(n, edges);
+  vector<double> gammas = as<vector<double>>(resolution);
+  size_t n_res = gammas.size();
+
+  // Best run per resolution; ties go to the lower restart so that the
+  // outcome does not depend on thread scheduling
+  vector<vector<int>> best(n_res);
+  vector<double> best_q(n_res, -numeric_limits<double>::infinity());
+  vector<int> best_run(n_res, -1);
+  long n_runs = static_cast<long>(n_res) * restarts;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (long run = 0; run < n_runs; ++run) {
+    size_t r = run / restarts;
+    CommunityDetector detector(gammas[r], refine, restart_seed(seed, run));
+    vector<int> membership = detector.run(graph);
+    double q = graph_modularity(graph, membership, 1.0);
+    if (q != q) {
+      q = -numeric_limits<double>::infinity();  // no edges: every partition ties
+    }
+#ifdef _OPENMP
+#pragma omp critical(clusterLouvain_best)
+#endif
+    {
+      if (best_run[r] < 0 || q > best_q[r] || (q == best_q[r] && run < best_run[r])) {
+        best_q[r] = q;
+        best_run[r] = static_cast<int>(run);
+        best[r].swap(membership);
+      }
+    }
+  }
+
+  size_t pick = 0;
+  NumericVector sweep_q(n_res);
+  IntegerVector sweep_k(n_res);
+  for (size_t r = 0; r < n_res; ++r) {
+    if (best_q[r] > best_q[pick]) {
+      pick = r;
+    }
+    sweep_q[r] = graph.total > 0.0 ? best_q[r] : NA_REAL;
+    sweep_k[r] = best[r].empty() ? 0 : *max_element(best[r].begin(), best[r].end()) + 1;
+  }
+
+  IntegerVector membership(n);
+  for (int v = 0; v < n; ++v) {
+    membership[v] = best[pick][v] + 1;
+  }
+  return List::create(Named("membership") = membership,
+                      Named("modularity") = sweep_q[pick],
+                      Named("resolution") = gammas[pick],
+                      Named("sweep") = DataFrame::create(Named("resolution") = resolution,
+                                                         Named("modularity") = sweep_q,
+                                                         Named("clusters") = sweep_k));
+}
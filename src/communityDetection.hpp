@@ -0,0 +1,408 @@
+#ifndef COMMUNITY_DETECTION_HPP
+#define COMMUNITY_DETECTION_HPP
+
+#include <vector>
+#include <deque>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+// Undirected weighted edge between nodes u and v (0-based)
+struct GraphEdge {
+  int u;
+  int v;
+  double weight;
+};
+
+// Weighted undirected graph in CSR form. Every edge is stored in both
+// adjacency lists; self-loops (which appear once communities are collapsed
+// into nodes) are kept apart in `self` as the diagonal entry A_ii.
+struct WeightedGraph {
+  int n;
+  vector<size_t> offsets;   // n + 1 row starts
+  vector<int> targets;
+  vector<double> weights;
+  vector<double> self;      // A_ii
+  vector<double> strength;  // k_i = sum_j A_ij, including A_ii
+  double total;             // 2m = sum_i k_i
+};
+
+// Build the CSR graph of n nodes from an edge list. Parallel edges are
+// merged by summing their weights; self-loops and non-positive weights are
+// ignored.
+inline WeightedGraph make_graph(int n, const vector<GraphEdge>& edges) {
+  WeightedGraph g;
+  g.n = n;
+  g.self.assign(n, 0.0);
+  g.strength.assign(n, 0.0);
+  g.total = 0.0;
+
+  vector<size_t> count(n + 1, 0);
+  for (const GraphEdge& e : edges) {
+    if (e.u != e.v && e.weight > 0.0) {
+      ++count[e.u + 1];
+      ++count[e.v + 1];
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    count[i + 1] += count[i];
+  }
+  vector<pair<int, double>> entries(count[n]);
+  vector<size_t> fill = count;
+  for (const GraphEdge& e : edges) {
+    if (e.u != e.v && e.weight > 0.0) {
+      entries[fill[e.u]++] = make_pair(e.v, e.weight);
+      entries[fill[e.v]++] = make_pair(e.u, e.weight);
+    }
+  }
+
+  // Sort each row by neighbour and merge duplicates
+  g.offsets.assign(n + 1, 0);
+  for (int i = 0; i < n; ++i) {
+    sort(entries.begin() + count[i], entries.begin() + count[i + 1]);
+    for (size_t e = count[i]; e < count[i + 1]; ++e) {
+      if (g.offsets[i + 1] > 0 && e > count[i] && entries[e].first == g.targets.back()) {
+        g.weights.back() += entries[e].second;
+      } else {
+        g.targets.push_back(entries[e].first);
+        g.weights.push_back(entries[e].second);
+        ++g.offsets[i + 1];
+      }
+      g.strength[i] += entries[e].second;
+    }
+    g.offsets[i + 1] += g.offsets[i];
+    g.total += g.strength[i];
+  }
+  return g;
+}
+
+// Modularity of a partition at the given resolution:
+// Q = sum_c [ in_c / 2m - resolution * (tot_c / 2m)^2 ]
+inline double graph_modularity(const WeightedGraph& g, const vector<int>& membership,
+                               double resolution) {
+  if (g.total <= 0.0) {
+    return numeric_limits<double>::quiet_NaN();
+  }
+  int n_comm = g.n == 0 ? 0 : *max_element(membership.begin(), membership.end()) + 1;
+  vector<double> inside(n_comm, 0.0), tot(n_comm, 0.0);
+  for (int v = 0; v < g.n; ++v) {
+    int c = membership[v];
+    tot[c] += g.strength[v];
+    inside[c] += g.self[v];
+    for (size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+      if (membership[g.targets[e]] == c) {
+        inside[c] += g.weights[e];
+      }
+    }
+  }
+  double q = 0.0;
+  for (int c = 0; c < n_comm; ++c) {
+    q += inside[c] / g.total - resolution * (tot[c] / g.total) * (tot[c] / g.total);
+  }
+  return q;
+}
+
+// Renumber community ids to 0..K-1 in order of first appearance; returns K
+inline int renumber_communities(vector<int>& membership) {
+  if (membership.empty()) {
+    return 0;
+  }
+  vector<int> id(*max_element(membership.begin(), membership.end()) + 1, -1);
+  int next = 0;
+  for (int& c : membership) {
+    if (id[c] < 0) {
+      id[c] = next++;
+    }
+    c = id[c];
+  }
+  return next;
+}
+
+// Seed of the randomised run `run` of a clustering seeded with `seed`
+inline uint64_t restart_seed(int seed, uint64_t run) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(seed)) << 32) |
+         static_cast<uint32_t>(run);
+}
+
+// Louvain community detection with optional Leiden refinement
+// (Traag, Waltman & van Eck, 2019).
+//
+// Each level moves nodes between communities with the queue-based local
+// moving of Leiden: a node goes to the neighbouring (or an empty) community
+// with the largest modularity gain, and only the neighbours of moved nodes
+// are revisited. With refinement, each community is then split into
+// well-connected subcommunities by greedily merging singletons inside it,
+// and the graph is collapsed by subcommunity while the collapsed nodes keep
+// their community; this guarantees connected communities. Without it the
+// graph is collapsed by community, as in Louvain. Levels repeat until
+// collapsing no longer merges any nodes.
+class CommunityDetector {
+private:
+  double resolution;
+  bool refine;
+  mt19937_64 rng;
+
+  // Scratch accumulator of the edge weight from one node to each community
+  vector<double> acc;
+  vector<int> touched;
+
+  void reset_touched() {
+    for (int c : touched) {
+      acc[c] = 0.0;
+    }
+    touched.clear();
+  }
+
+  void add_weight(int c, double w) {
+    if (acc[c] == 0.0) {
+      touched.push_back(c);
+    }
+    acc[c] += w;
+  }
+
+  // Local moving of nodes on `g`; `comm` holds ids in [0, g.n)
+  void move_nodes(const WeightedGraph& g, vector<int>& comm) {
+    const double scale = resolution / g.total;
+    vector<double> tot(g.n, 0.0);
+    vector<int> size(g.n, 0);
+    for (int v = 0; v < g.n; ++v) {
+      tot[comm[v]] += g.strength[v];
+      ++size[comm[v]];
+    }
+    vector<int> empty;
+    for (int c = g.n - 1; c >= 0; --c) {
+      if (size[c] == 0) {
+        empty.push_back(c);
+      }
+    }
+
+    vector<int> order(g.n);
+    for (int v = 0; v < g.n; ++v) {
+      order[v] = v;
+    }
+    shuffle(order.begin(), order.end(), rng);
+    deque<int> queue(order.begin(), order.end());
+    vector<char> queued(g.n, 1);
+
+    while (!queue.empty()) {
+      int v = queue.front();
+      queue.pop_front();
+      queued[v] = 0;
+
+      int old = comm[v];
+      double k = g.strength[v];
+      tot[old] -= k;
+      --size[old];
+      if (size[old] == 0) {
+        empty.push_back(old);
+      }
+
+      for (size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+        add_weight(comm[g.targets[e]], g.weights[e]);
+      }
+
+      // Staying alone (an empty community) gains nothing
+      int best = size[old] == 0 ? old : -1;
+      double best_gain = 0.0;
+      if (size[old] > 0) {
+        best_gain = acc[old] - k * tot[old] * scale;
+        best = old;
+      }
+      for (int c : touched) {
+        double gain = acc[c] - k * tot[c] * scale;
+        if (gain > best_gain) {
+          best_gain = gain;
+          best = c;
+        }
+      }
+      if (best_gain < 0.0) {
+        best = empty.back();
+      }
+      reset_touched();
+
+      // An empty target is always the most recently freed id
+      if (size[best] == 0) {
+        empty.pop_back();
+      }
+      tot[best] += k;
+      ++size[best];
+      comm[v] = best;
+
+      if (best != old) {
+        for (size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+          int u = g.targets[e];
+          if (!queued[u] && comm[u] != best) {
+            queued[u] = 1;
+            queue.push_back(u);
+          }
+        }
+      }
+    }
+  }
+
+  // Leiden refinement: split every community of `comm` into well-connected
+  // subcommunities, returned as ids in [0, g.n)
+  vector<int> refine_partition(const WeightedGraph& g, const vector<int>& comm) {
+    const double scale = resolution / g.total;
+    vector<double> comm_tot(g.n, 0.0);
+    for (int v = 0; v < g.n; ++v) {
+      comm_tot[comm[v]] += g.strength[v];
+    }
+
+    // Every node starts as its own subcommunity; `external` is the weight
+    // from a subcommunity to the rest of its community
+    vector<int> sub(g.n);
+    vector<double> sub_tot(g.strength);
+    vector<double> external(g.n, 0.0);
+    vector<char> singleton(g.n, 1);
+    for (int v = 0; v < g.n; ++v) {
+      sub[v] = v;
+      for (size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+        if (comm[g.targets[e]] == comm[v]) {
+          external[v] += g.weights[e];
+        }
+      }
+    }
+
+    vector<int> order(g.n);
+    for (int v = 0; v < g.n; ++v) {
+      order[v] = v;
+    }
+    shuffle(order.begin(), order.end(), rng);
+
+    for (int v : order) {
+      if (!singleton[v]) {
+        continue;
+      }
+      double k = g.strength[v];
+      double rest = comm_tot[comm[v]];
+      if (external[v] < k * (rest - k) * scale) {
+        continue;  // not well connected to its own community
+      }
+
+      for (size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+        int u = g.targets[e];
+        if (comm[u] == comm[v]) {
+          add_weight(sub[u], g.weights[e]);
+        }
+      }
+      int best = v;
+      double best_gain = 0.0;
+      for (int s : touched) {
+        if (s == v || external[s] < sub_tot[s] * (rest - sub_tot[s]) * scale) {
+          continue;
+        }
+        double gain = acc[s] - k * sub_tot[s] * scale;
+        if (gain > best_gain) {
+          best_gain = gain;
+          best = s;
+        }
+      }
+      if (best != v) {
+        external[best] += external[v] - 2.0 * acc[best];
+        sub_tot[best] += k;
+        sub_tot[v] = 0.0;
+        singleton[best] = 0;
+        singleton[v] = 0;
+        sub[v] = best;
+      }
+      reset_touched();
+    }
+    return sub;
+  }
+
+  // Collapse every group of `part` (ids 0..K-1) into one node
+  static WeightedGraph collapse(const WeightedGraph& g, const vector<int>& part, int K) {
+    WeightedGraph h;
+    h.n = K;
+    h.self.assign(K, 0.0);
+    h.strength.assign(K, 0.0);
+    h.offsets.assign(K + 1, 0);
+    h.total = g.total;
+
+    vector<vector<int>> members(K);
+    for (int v = 0; v < g.n; ++v) {
+      members[part[v]].push_back(v);
+    }
+    vector<double> acc(K, 0.0);
+    vector<int> touched;
+    for (int c = 0; c < K; ++c) {
+      for (int v : members[c]) {
+        h.self[c] += g.self[v];
+        h.strength[c] += g.strength[v];
+        for (size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+          int d = part[g.targets[e]];
+          if (d == c) {
+            h.self[c] += g.weights[e];
+          } else {
+            if (acc[d] == 0.0) {
+              touched.push_back(d);
+            }
+            acc[d] += g.weights[e];
+          }
+        }
+      }
+      sort(touched.begin(), touched.end());
+      for (int d : touched) {
+        h.targets.push_back(d);
+        h.weights.push_back(acc[d]);
+        acc[d] = 0.0;
+      }
+      h.offsets[c + 1] = h.offsets[c] + touched.size();
+      touched.clear();
+    }
+    return h;
+  }
+
+public:
+  CommunityDetector(double resolution, bool refine, uint64_t seed)
+    : resolution(resolution), refine(refine), rng(seed) {}
+
+  // Community of every node of `graph`, numbered 0..K-1
+  vector<int> run(const WeightedGraph& graph) {
+    vector<int> node_of(graph.n), comm(graph.n);
+    for (int v = 0; v < graph.n; ++v) {
+      node_of[v] = v;
+      comm[v] = v;
+    }
+    if (graph.total <= 0.0) {
+      return comm;
+    }
+
+    WeightedGraph level = graph;
+    while (true) {
+      acc.assign(level.n, 0.0);
+      move_nodes(level, comm);
+
+      vector<int> part = refine ? refine_partition(level, comm) : comm;
+      int K = renumber_communities(part);
+      if (K == level.n) {
+        break;
+      }
+
+      // Collapsed nodes start in the community their members were moved to
+      vector<int> next(K);
+      for (int v = 0; v < level.n; ++v) {
+        next[part[v]] = comm[v];
+      }
+      renumber_communities(next);
+      for (int& node : node_of) {
+        node = part[node];
+      }
+      level = collapse(level, part, K);
+      comm = next;
+    }
+
+    vector<int> membership(graph.n);
+    for (int v = 0; v < graph.n; ++v) {
+      membership[v] = comm[node_of[v]];
+    }
+    renumber_communities(membership);
+    return membership;
+  }
+};
+
+#endif // COMMUNITY_DETECTION_HPP
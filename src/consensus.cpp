@@ -0,0 +1,56 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "consensus.hpp"
+#include "needlemanWunsch.hpp"
+#include "pairScheduler.hpp"
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+//' @name consensusSequences
+//' @title Native Consensus Sequences of Clusters
+//'
+//' @description
+//' Builds a center-star alignment of every cluster with the affine-gap
+//' Needleman-Wunsch kernel of [similarityNW()] and returns its majority
+//' consensus. The center is the member with the largest total similarity to
+//' the others; every member is aligned to it, and a column contributes its
+//' most frequent residue when residues outnumber gaps (ties go to the
+//' center's residue). Clusters are processed in parallel, largest first.
+//' This is the engine of `clusterconsensus(method = "native")`.
+//'
+//' @param sequences A character vector of amino acid sequences
+//' @param clusters 1-based cluster of each sequence
+//' @param matrixName Substitution matrix, as in [similarityNW()]
+//'        (default: "BLOSUM62")
+//' @param gapOpen Gap opening penalty, as in [similarityNW()] (default: 10)
+//' @param gapExt Gap extension penalty, as in [similarityNW()] (default: 4)
+//' @param threads Number of threads (default: 0, all available cores)
+//' @return A character vector with the consensus of clusters
+//'         `1, ..., max(clusters)`; clusters without members get `""`
+//' @export
+// [[Rcpp::export]]
+CharacterVector consensusSequences(CharacterVector sequences, IntegerVector clusters,
+                                   std::string matrixName = "BLOSUM62",
+                                   int gapOpen = 10, int gapExt = 4, int threads = 0) {
+  if (clusters.length() != sequences.length()) {
+    Rcpp::stop("'clusters' must have one entry per sequence");
+  }
+  vector<size_t> index(clusters.length());
+  size_t n_clusters = 0;
+  for (size_t s = 0; s < index.size(); ++s) {
+    if (clusters[s] == NA_INTEGER || clusters[s] < 1) {
+      Rcpp::stop("'clusters' must be positive integers");
+    }
+    index[s] = static_cast<size_t>(clusters[s] - 1);
+    n_clusters = std::max(n_clusters, index[s] + 1);
+  }
+  const int (*substitutionMatrix)[24] = getSubstitutionMatrix(matrixName);
+  int n_threads = resolve_threads(threads);
+
+  vector<string> consensus = cluster_consensus(as<vector<string>>(sequences), index, n_clusters,
+                                               substitutionMatrix, gapOpen, gapExt, n_threads);
+  return wrap(consensus);
+}
@@ -0,0 +1,271 @@
+#ifndef CONSENSUS_HPP
+#define CONSENSUS_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include "alphabet.hpp"
+#include "needlemanWunsch.hpp"
+#include "pairScheduler.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// Traceback steps of a global alignment of `center` (rows) against another
+// sequence (columns)
+const uint8_t STEP_DIAGONAL = 0;
+const uint8_t STEP_UP = 1;      // center residue against a gap
+const uint8_t STEP_LEFT = 2;    // residue inserted before a center residue
+
+// Per-thread state of the consensus engine, reused across clusters
+struct ConsensusWorkspace {
+  NWWorkspace nw;
+  vector<NWCell> prev;
+  vector<NWCell> cur;
+  vector<uint8_t> steps;
+  vector<uint8_t> path;
+  vector<double> affinity;
+  vector<uint32_t> columns;         // center column p -> residue counts
+  vector<vector<uint32_t>> slots;   // center column p -> counts of the insert slots before it
+};
+
+// Forward traceback of the alignment calculate_similarity() scores: the same
+// affine-gap recurrences and tie-breaking, with the step of every cell kept
+// so the path can be replayed. Fills ws.path, first step first.
+inline void align_path(const vector<uint8_t>& center, const vector<uint8_t>& sequence,
+                       const int substitutionMatrix[24][24], int gapOpen, int gapExt,
+                       ConsensusWorkspace& ws) {
+  size_t m = center.size();
+  size_t n = sequence.size();
+  size_t width = n + 1;
+  const int NEG_INF = std::numeric_limits<int>::min() / 2;
+
+  if (ws.prev.size() < width) {
+    ws.prev.resize(width);
+    ws.cur.resize(width);
+  }
+  ws.steps.resize((m + 1) * width);
+  NWCell* prev = ws.prev.data();
+  NWCell* cur = ws.cur.data();
+  uint8_t* steps = ws.steps.data();
+
+  prev[0].M = 0;
+  prev[0].Ix = prev[0].Iy = NEG_INF;
+  for (size_t j = 1; j <= n; ++j) {
+    prev[j].M = NEG_INF;
+    prev[j].Ix = NEG_INF;
+    prev[j].Iy = -gapOpen - static_cast<int>(j - 1) * gapExt;
+    steps[j] = STEP_LEFT;
+  }
+
+  for (size_t i = 1; i <= m; ++i) {
+    uint8_t aa1 = center[i - 1];
+    const int* scores = substitutionMatrix[aa1];
+    uint8_t* row = steps + i * width;
+    cur[0].M = NEG_INF;
+    cur[0].Ix = -gapOpen - static_cast<int>(i - 1) * gapExt;
+    cur[0].Iy = NEG_INF;
+    row[0] = STEP_UP;
+
+    for (size_t j = 1; j <= n; ++j) {
+      const NWCell& up = prev[j];
+      const NWCell& diag = prev[j - 1];
+      const NWCell& left = cur[j - 1];
+      NWCell& cell = cur[j];
+      cell.Ix = std::max(up.M - (gapOpen + gapExt), up.Ix - gapExt);
+      cell.Iy = std::max(left.M - (gapOpen + gapExt), left.Iy - gapExt);
+      int best = std::max({ diag.M, diag.Ix, diag.Iy }) + scores[sequence[j - 1]];
+      if (best >= cell.Ix && best >= cell.Iy) {
+        row[j] = STEP_DIAGONAL;
+      } else if (cell.Ix >= cell.Iy) {
+        best = cell.Ix;
+        row[j] = STEP_UP;
+      } else {
+        best = cell.Iy;
+        row[j] = STEP_LEFT;
+      }
+      cell.M = best;
+    }
+    std::swap(prev, cur);
+  }
+
+  // Walk back from (m, n), then reverse
+  ws.path.clear();
+  size_t i = m;
+  size_t j = n;
+  while (i > 0 || j > 0) {
+    uint8_t step = steps[i * width + j];
+    ws.path.push_back(step);
+    if (step != STEP_LEFT) {
+      --i;
+    }
+    if (step != STEP_UP) {
+      --j;
+    }
+  }
+  std::reverse(ws.path.begin(), ws.path.end());
+}
+
+// Member with the largest total similarity to the other members: the center
+// of a center-star alignment. Ties go to the earlier member.
+inline size_t star_center(const vector<vector<uint8_t>>& encoded, const vector<size_t>& members,
+                          const int substitutionMatrix[24][24], int gapOpen, int gapExt,
+                          ConsensusWorkspace& ws) {
+  size_t size = members.size();
+  if (size <= 2) {
+    return 0;
+  }
+  ws.affinity.assign(size, 0.0);
+  for (size_t a = 0; a < size; ++a) {
+    for (size_t b = a + 1; b < size; ++b) {
+      double similarity = calculate_similarity(encoded[members[a]], encoded[members[b]],
+                                               substitutionMatrix, gapOpen, gapExt, ws.nw);
+      ws.affinity[a] += similarity;
+      ws.affinity[b] += similarity;
+    }
+  }
+  return static_cast<size_t>(std::max_element(ws.affinity.begin(), ws.affinity.end()) -
+                             ws.affinity.begin());
+}
+
+// Most frequent residue of one alignment column, or -1 when gaps are at
+// least as frequent as residues. Ties go to `preferred`, then to the
+// earlier residue in matrix order.
+inline int majority_residue(const uint32_t* counts, uint32_t members, int preferred) {
+  uint32_t residues = 0;
+  int best = -1;
+  for (int r = 0; r < ALPHABET_SIZE; ++r) {
+    residues += counts[r];
+    if (counts[r] > 0 && (best < 0 || counts[r] > counts[best])) {
+      best = r;
+    }
+  }
+  if (residues * 2 <= members) {
+    return -1;
+  }
+  if (preferred >= 0 && counts[preferred] == counts[best]) {
+    return preferred;
+  }
+  return best;
+}
+
+// Majority consensus of one cluster. Every member is aligned to the center
+// (star_center()) and the pairwise alignments are merged: residues a member
+// inserts before center column p fill the insert slots before p from the
+// left, so each column is counted without building the alignment itself.
+inline string star_consensus(const vector<vector<uint8_t>>& encoded, const vector<size_t>& members,
+                             const int substitutionMatrix[24][24], int gapOpen, int gapExt,
+                             ConsensusWorkspace& ws) {
+  if (members.empty()) {
+    return string();
+  }
+  const vector<uint8_t>& center = encoded[members[star_center(encoded, members,
+                                                              substitutionMatrix, gapOpen,
+                                                              gapExt, ws)]];
+  size_t length = center.size();
+  ws.columns.assign(length * ALPHABET_SIZE, 0);
+  if (ws.slots.size() < length + 1) {
+    ws.slots.resize(length + 1);
+  }
+  for (size_t p = 0; p <= length; ++p) {
+    ws.slots[p].clear();
+  }
+  vector<vector<uint32_t>>& slots = ws.slots;
+
+  for (size_t s = 0; s < members.size(); ++s) {
+    const vector<uint8_t>& sequence = encoded[members[s]];
+    align_path(center, sequence, substitutionMatrix, gapOpen, gapExt, ws);
+    size_t i = 0;
+    size_t j = 0;
+    size_t inserted = 0;
+    for (size_t step = 0; step < ws.path.size(); ++step) {
+      switch (ws.path[step]) {
+      case STEP_DIAGONAL:
+        ++ws.columns[i * ALPHABET_SIZE + sequence[j]];
+        ++i;
+        ++j;
+        inserted = 0;
+        break;
+      case STEP_UP:
+        ++i;
+        inserted = 0;
+        break;
+      default:
+        if (slots[i].size() <= inserted * ALPHABET_SIZE) {
+          slots[i].resize((inserted + 1) * ALPHABET_SIZE, 0u);
+        }
+        ++slots[i][inserted * ALPHABET_SIZE + sequence[j]];
+        ++inserted;
+        ++j;
+        break;
+      }
+    }
+  }
+
+  uint32_t n_members = static_cast<uint32_t>(members.size());
+  string consensus;
+  consensus.reserve(length);
+  for (size_t p = 0; p <= length; ++p) {
+    for (size_t slot = 0; slot < slots[p].size(); slot += ALPHABET_SIZE) {
+      int residue = majority_residue(&slots[p][slot], n_members, -1);
+      if (residue >= 0) {
+        consensus.push_back(RESIDUE_SYMBOLS[residue]);
+      }
+    }
+    if (p < length) {
+      int residue = majority_residue(&ws.columns[p * ALPHABET_SIZE], n_members, center[p]);
+      if (residue >= 0) {
+        consensus.push_back(RESIDUE_SYMBOLS[residue]);
+      }
+    }
+  }
+  return consensus;
+}
+
+// Consensus of every cluster: `clusters[s]` is the 0-based cluster of
+// sequence s, and clusters without members get an empty consensus.
+// Sequences are encoded up front, so invalid residues are reported before
+// the parallel region; clusters are then processed largest first, one per
+// thread at a time.
+inline vector<string> cluster_consensus(const vector<string>& sequences,
+                                        const vector<size_t>& clusters, size_t n_clusters,
+                                        const int substitutionMatrix[24][24], int gapOpen,
+                                        int gapExt, int n_threads) {
+  vector<vector<uint8_t>> encoded = encode_sequences(sequences);
+  vector<vector<size_t>> members(n_clusters);
+  for (size_t s = 0; s < clusters.size(); ++s) {
+    members[clusters[s]].push_back(s);
+  }
+  vector<size_t> order(n_clusters);
+  for (size_t c = 0; c < n_clusters; ++c) {
+    order[c] = c;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return members[a].size() > members[b].size();
+  });
+
+  vector<string> consensus(n_clusters);
+  long n_order = static_cast<long>(n_clusters);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    ConsensusWorkspace ws;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long o = 0; o < n_order; ++o) {
+      size_t c = order[o];
+      consensus[c] = star_consensus(encoded, members[c], substitutionMatrix, gapOpen, gapExt, ws);
+    }
+  }
+  return consensus;
+}
+
+#endif // CONSENSUS_HPP
@@ -0,0 +1,44 @@
+#ifndef CORE_ERROR_HPP
+#define CORE_ERROR_HPP
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Error raised by the similarity core, which does not depend on Rcpp so that
+// it also builds into the command-line tool. Exported functions let it
+// propagate: Rcpp turns any std::exception into an R error with the same
+// message, and the command-line tool prints it.
+class CoreError : public runtime_error {
+public:
+  explicit CoreError(const string& message) : runtime_error(message) {}
+};
+
+// printf-style arguments, with strings passed as C strings
+inline const char* core_format_arg(const string& value) {
+  return value.c_str();
+}
+
+template <typename T>
+inline T core_format_arg(T value) {
+  return value;
+}
+
+[[noreturn]] inline void core_stop(const char* message) {
+  throw CoreError(message);
+}
+
+// Throw a CoreError whose message is `format` filled in like printf
+template <typename T, typename... Args>
+[[noreturn]] inline void core_stop(const char* format, const T& first, const Args&... rest) {
+  int size = snprintf(nullptr, 0, format, core_format_arg(first), core_format_arg(rest)...);
+  string message(size > 0 ? size : 0, '\0');
+  if (size > 0) {
+    snprintf(&message[0], size + 1, format, core_format_arg(first), core_format_arg(rest)...);
+  }
+  throw CoreError(message);
+}
+
+#endif // CORE_ERROR_HPP
@@ -0,0 +1,44 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "duplicateIndex.hpp"
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+//' @name collapseDuplicates
+//' @title Collapse Identical Sequences
+//'
+//' @description
+//' Groups exactly identical sequences, so that pairwise similarities can be
+//' computed on the distinct sequences only and mapped back with `groups`.
+//' This is what `dedup = "expand"` and `dedup = "collapse"` do inside
+//' [similarityMH()] and [similarityNW()]; use it directly to reuse the
+//' grouping, e.g. with [createSignatureStore()].
+//'
+//' @param sequences A character vector of input sequences
+//' @return A list with the distinct `sequences` in order of first
+//'         occurrence, their `multiplicity` (number of copies), the 1-based
+//'         position of the first copy of each in `representative`, and for
+//'         every input sequence the index of its distinct sequence in
+//'         `groups`, so that `sequences[groups]` is the input
+//' @export
+// [[Rcpp::export]]
+List collapseDuplicates(CharacterVector sequences) {
+  vector<string> seqs = as<vector<string>>(sequences);
+  DuplicateIndex duplicates = collapse_duplicates(seqs);
+  IntegerVector multiplicity(duplicates.multiplicity.begin(), duplicates.multiplicity.end());
+  IntegerVector representative(duplicates.distinct());
+  for (size_t u = 0; u < duplicates.distinct(); ++u) {
+    representative[u] = static_cast<int>(duplicates.representative[u]) + 1;
+  }
+  IntegerVector groups(duplicates.size());
+  for (size_t i = 0; i < duplicates.size(); ++i) {
+    groups[i] = duplicates.group[i] + 1;
+  }
+  return List::create(Named("sequences") = wrap(distinct_sequences(seqs, duplicates)),
+                      Named("multiplicity") = multiplicity,
+                      Named("representative") = representative,
+                      Named("groups") = groups);
+}
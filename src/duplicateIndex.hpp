@@ -0,0 +1,100 @@
+#ifndef DUPLICATE_INDEX_HPP
+#define DUPLICATE_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// Identical sequences collapsed to their first occurrence, so that pairwise
+// kernels run on the distinct sequences only and their results can be
+// mapped back to the original indices.
+struct DuplicateIndex {
+  vector<size_t> representative;  // distinct sequence u -> index of its first copy
+  vector<int> group;              // sequence i -> its distinct sequence
+  vector<uint64_t> multiplicity;  // distinct sequence u -> number of copies
+
+  size_t size() const {
+    return group.size();
+  }
+
+  size_t distinct() const {
+    return representative.size();
+  }
+
+  // Original pairs i < j made of copies of u and v: the pairs within u when
+  // u == v, so a kernel can weight the score of (u, v) by it
+  uint64_t pairs(size_t u, size_t v) const {
+    return u == v ? multiplicity[u] * (multiplicity[u] - 1) / 2
+                  : multiplicity[u] * multiplicity[v];
+  }
+
+  // Original indices of the copies of each distinct sequence, in order
+  vector<vector<int>> members() const {
+    vector<vector<int>> out(distinct());
+    for (size_t u = 0; u < out.size(); ++u) {
+      out[u].reserve(multiplicity[u]);
+    }
+    for (size_t i = 0; i < group.size(); ++i) {
+      out[group[i]].push_back(static_cast<int>(i));
+    }
+    return out;
+  }
+};
+
+// Group exactly equal sequences. Each sequence is hashed once (in parallel);
+// only sequences with equal hashes are compared.
+inline DuplicateIndex collapse_duplicates(const vector<string>& seqs) {
+  size_t n = seqs.size();
+  vector<size_t> hashes(n);
+  long n_seqs = static_cast<long>(n);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (long i = 0; i < n_seqs; ++i) {
+    hashes[i] = hash<string>()(seqs[i]);
+  }
+
+  // Distinct sequences by hash; the rare collisions share a bucket list
+  DuplicateIndex index;
+  index.group.resize(n);
+  unordered_multimap<size_t, int> seen(n);
+  for (size_t i = 0; i < n; ++i) {
+    int found = -1;
+    auto range = seen.equal_range(hashes[i]);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (seqs[index.representative[it->second]] == seqs[i]) {
+        found = it->second;
+        break;
+      }
+    }
+    if (found < 0) {
+      found = static_cast<int>(index.representative.size());
+      seen.insert(make_pair(hashes[i], found));
+      index.representative.push_back(i);
+      index.multiplicity.push_back(0);
+    }
+    index.group[i] = found;
+    ++index.multiplicity[found];
+  }
+  return index;
+}
+
+// The distinct sequences, in order of first occurrence
+inline vector<string> distinct_sequences(const vector<string>& seqs, const DuplicateIndex& index) {
+  vector<string> out(index.distinct());
+  for (size_t u = 0; u < out.size(); ++u) {
+    out[u] = seqs[index.representative[u]];
+  }
+  return out;
+}
+
+#endif // DUPLICATE_INDEX_HPP
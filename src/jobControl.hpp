@@ -0,0 +1,163 @@
+#ifndef JOB_CONTROL_HPP
+#define JOB_CONTROL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+// Progress, cooperative cancellation and errors of a pairwise kernel. The
+// kernels skip their remaining work units once stopped() is set and report
+// each finished unit with advance(). Exceptions must never leave an OpenMP
+// region or a worker thread, so guard() records the first one for the
+// owning thread to rethrow.
+class JobControl {
+private:
+  atomic<uint64_t> done;
+  uint64_t total;
+  atomic<bool> cancel_requested;
+  atomic<bool> failed;
+  mutable mutex lock;
+  exception_ptr error;
+  chrono::steady_clock::time_point started;
+  chrono::steady_clock::time_point finished;
+  bool running;
+
+public:
+  // A job of `total` pairs, started now
+  explicit JobControl(uint64_t total)
+    : done(0), total(total), cancel_requested(false), failed(false),
+      started(chrono::steady_clock::now()), finished(started), running(true) {}
+
+  void advance(uint64_t pairs) {
+    done.fetch_add(pairs, memory_order_relaxed);
+  }
+
+  void cancel() {
+    cancel_requested.store(true, memory_order_relaxed);
+  }
+
+  // Whether the remaining work should be skipped
+  bool stopped() const {
+    return cancel_requested.load(memory_order_relaxed) || failed.load(memory_order_relaxed);
+  }
+
+  // Record `e` unless an earlier error was recorded, and stop the job
+  void fail(exception_ptr e) {
+    lock_guard<mutex> guard(lock);
+    if (!error) {
+      error = e;
+    }
+    failed.store(true, memory_order_relaxed);
+  }
+
+  // Run f() unless the job is stopped, recording what it throws
+  template <typename F>
+  void guard(F f) {
+    if (stopped()) {
+      return;
+    }
+    try {
+      f();
+    } catch (...) {
+      fail(current_exception());
+    }
+  }
+
+  // Rethrow the recorded error, if any, on the calling thread
+  void rethrow() const {
+    lock_guard<mutex> guard(lock);
+    if (error) {
+      rethrow_exception(error);
+    }
+  }
+
+  void finish() {
+    lock_guard<mutex> guard(lock);
+    finished = chrono::steady_clock::now();
+    running = false;
+  }
+
+  uint64_t pairs_done() const {
+    return done.load(memory_order_relaxed);
+  }
+
+  uint64_t pairs_total() const {
+    return total;
+  }
+
+  bool has_failed() const {
+    return failed.load(memory_order_relaxed);
+  }
+
+  // Seconds since the job started, up to its end once finished
+  double elapsed() const {
+    lock_guard<mutex> guard(lock);
+    chrono::steady_clock::time_point end = running ? chrono::steady_clock::now() : finished;
+    return chrono::duration<double>(end - started).count();
+  }
+};
+
+// A kernel of `total` pairs running on a worker thread, which may itself
+// start an OpenMP team. The work gets the job's JobControl; destroying the
+// job cancels it and waits for the worker.
+class BackgroundJob {
+private:
+  JobControl job_control;
+  mutable mutex lock;
+  condition_variable done_signal;
+  bool done;
+  thread worker;  // last, so it starts once the members above exist
+
+public:
+  template <typename F>
+  BackgroundJob(uint64_t total, F work)
+    : job_control(total), done(false), worker([this, work]() {
+        job_control.guard([&]() { work(job_control); });
+        job_control.finish();
+        lock_guard<mutex> guard(lock);
+        done = true;
+        done_signal.notify_all();
+      }) {}
+
+  ~BackgroundJob() {
+    job_control.cancel();
+    wait();
+  }
+
+  BackgroundJob(const BackgroundJob&) = delete;
+  BackgroundJob& operator=(const BackgroundJob&) = delete;
+
+  JobControl& control() {
+    return job_control;
+  }
+
+  const JobControl& control() const {
+    return job_control;
+  }
+
+  bool finished() const {
+    lock_guard<mutex> guard(lock);
+    return done;
+  }
+
+  // Wait up to `seconds` for the worker; true once it has finished
+  bool wait_for(double seconds) {
+    unique_lock<mutex> guard(lock);
+    return done_signal.wait_for(guard, chrono::duration<double>(seconds), [this]() { return done; });
+  }
+
+  // Wait for the worker and release its thread
+  void wait() {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+};
+
+#endif // JOB_CONTROL_HPP
@@ -0,0 +1,84 @@
+#ifndef KERNEL_PROFILE_HPP
+#define KERNEL_PROFILE_HPP
+
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// Opt-in wall times and counters of one similarity call, returned as a named
+// numeric vector in attr(, "profile"). Phases are timed from begin() to the
+// next begin() or end(), as "<phase>_seconds". Nothing is recorded on the
+// hot paths: kernels count into their own per-thread state and report the
+// totals once, so a disabled profile costs one branch per phase.
+class KernelProfile {
+private:
+  bool enabled;
+  vector<string> names;
+  vector<double> values;
+  string phase;
+  chrono::steady_clock::time_point started;
+
+  void add(const string& name, double value) {
+    for (size_t v = 0; v < names.size(); ++v) {
+      if (names[v] == name) {
+        values[v] += value;
+        return;
+      }
+    }
+    names.push_back(name);
+    values.push_back(value);
+  }
+
+public:
+  explicit KernelProfile(bool enabled = false) : enabled(enabled) {}
+
+  bool active() const {
+    return enabled;
+  }
+
+  // Start timing `name`, ending the phase in progress
+  void begin(const char* name) {
+    if (!enabled) {
+      return;
+    }
+    end();
+    phase = name;
+    started = chrono::steady_clock::now();
+  }
+
+  void end() {
+    if (!enabled || phase.empty()) {
+      return;
+    }
+    add(phase + "_seconds",
+        chrono::duration<double>(chrono::steady_clock::now() - started).count());
+    phase.clear();
+  }
+
+  // Add `value` to the counter `name`
+  void count(const char* name, double value) {
+    if (enabled) {
+      add(name, value);
+    }
+  }
+
+  // End the last phase and attach the profile to `result`
+  SEXP attach(SEXP result) {
+    if (!enabled) {
+      return result;
+    }
+    end();
+    NumericVector profile(values.begin(), values.end());
+    profile.names() = wrap(names);
+    RObject object(result);
+    object.attr("profile") = profile;
+    return object;
+  }
+};
+
+#endif // KERNEL_PROFILE_HPP
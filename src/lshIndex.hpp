@@ -0,0 +1,145 @@
+#ifndef LSH_INDEX_HPP
+#define LSH_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include "minHash.hpp"
+#include "packedSignatures.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// Sequence indices of one band sorted by bucket key, so that each run of
+// equal keys is a bucket
+inline vector<pair<uint32_t, int>> lsh_band_table(const vector<uint32_t>& keys, size_t n,
+                                                  int bands, int b) {
+  vector<pair<uint32_t, int>> table(n);
+  for (size_t i = 0; i < n; ++i) {
+    table[i] = make_pair(keys[i * bands + b], static_cast<int>(i));
+  }
+  sort(table.begin(), table.end());
+  return table;
+}
+
+// Largest band width (rows) for signatures of n_hash slots, cut into
+// n_hash / rows bands, at which a pair of similarity s still becomes a
+// candidate with probability at least `recall`; 1 when none reaches it
+inline int lsh_rows_for_recall(int n_hash, double s, double recall) {
+  for (int rows = n_hash; rows > 1; --rows) {
+    int bands = n_hash / rows;
+    if (1.0 - std::pow(1.0 - std::pow(s, rows), bands) >= recall) {
+      return rows;
+    }
+  }
+  return 1;
+}
+
+// LSH banding index over the first bands * rows slots of `signatures`: two
+// sequences are candidates when their slots agree over a whole band. Calls
+// visit(i, j) with i < j once per candidate pair, in the first band the pair
+// shares, from any of `n_threads` OpenMP threads (0 uses the OpenMP default).
+//
+// A bucket of more than `max_bucket` sequences (0: no limit) only pairs
+// members fewer than max_bucket places apart in input order, so a band costs
+// at most n * max_bucket pairs even when many sequences share their band
+// values, while the members of a large family stay connected. Returns the
+// number of buckets capped this way.
+template <typename F>
+size_t for_each_lsh_candidate(const PackedSignatures& signatures, int bands, int rows,
+                              size_t max_bucket, int n_threads, F visit) {
+  size_t n = signatures.size();
+  size_t window = max_bucket == 0 ? n : max_bucket;
+#ifdef _OPENMP
+  if (n_threads <= 0) {
+    n_threads = omp_get_max_threads();
+  }
+#endif
+
+  // Bucket key of every (sequence, band): a hash of the band's signature values
+  vector<uint32_t> keys(n * bands);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    vector<uint32_t> band(rows);
+#ifdef _OPENMP
+#pragma omp for
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      for (int b = 0; b < bands; ++b) {
+        for (int r = 0; r < rows; ++r) {
+          band[r] = signatures.slot(i, b * rows + r);
+        }
+        keys[i * bands + b] = murmur3_32(reinterpret_cast<const char*>(band.data()),
+                                         rows * sizeof(uint32_t), b);
+      }
+    }
+  }
+
+  // Position of every (sequence, band) within its bucket: a pair was visited
+  // in an earlier band iff it shares that band's key within the window
+  vector<uint32_t> rank(n * bands);
+  size_t capped = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) reduction(+:capped)
+#endif
+  for (int b = 0; b < bands; ++b) {
+    vector<pair<uint32_t, int>> table = lsh_band_table(keys, n, bands, b);
+    for (size_t start = 0; start < n; ) {
+      size_t end = start + 1;
+      while (end < n && table[end].first == table[start].first) {
+        ++end;
+      }
+      for (size_t x = start; x < end; ++x) {
+        rank[table[x].second * static_cast<size_t>(bands) + b] = static_cast<uint32_t>(x - start);
+      }
+      capped += end - start > window ? 1 : 0;
+      start = end;
+    }
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+  for (int b = 0; b < bands; ++b) {
+    vector<pair<uint32_t, int>> table = lsh_band_table(keys, n, bands, b);
+    for (size_t start = 0; start < n; ) {
+      size_t end = start + 1;
+      while (end < n && table[end].first == table[start].first) {
+        ++end;
+      }
+
+      // Pairs of the bucket, up to `window` members apart
+      for (size_t x = start; x < end; ++x) {
+        size_t y_end = min(end, x + window);
+        for (size_t y = x + 1; y < y_end; ++y) {
+          size_t i = table[x].second;
+          size_t j = table[y].second;
+          const uint32_t* keys_i = &keys[i * bands];
+          const uint32_t* keys_j = &keys[j * bands];
+          const uint32_t* rank_i = &rank[i * bands];
+          const uint32_t* rank_j = &rank[j * bands];
+
+          bool seen = false;
+          for (int prev = 0; prev < b && !seen; ++prev) {
+            seen = keys_i[prev] == keys_j[prev] &&
+              max(rank_i[prev], rank_j[prev]) - min(rank_i[prev], rank_j[prev]) < window;
+          }
+          if (!seen) {
+            visit(static_cast<int>(i), static_cast<int>(j));
+          }
+        }
+      }
+      start = end;
+    }
+  }
+  return capped;
+}
+
+#endif // LSH_INDEX_HPP
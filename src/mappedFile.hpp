@@ -0,0 +1,104 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include "coreError.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Read-only memory mapping of a whole file; `what` names the file in errors
+class MappedFile {
+private:
+  const char* bytes;
+  size_t length;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#endif
+
+public:
+  explicit MappedFile(const string& path, const char* what = "file") : bytes(0), length(0) {
+#ifdef _WIN32
+    mapping = 0;
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+      core_stop("Cannot open %s: %s", what, path);
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    length = static_cast<size_t>(size.QuadPart);
+    if (length > 0) {
+      mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+      bytes = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : 0;
+      if (!bytes) {
+        if (mapping) {
+          CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        core_stop("Cannot map %s: %s", what, path);
+      }
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      core_stop("Cannot open %s: %s", what, path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      core_stop("Cannot open %s: %s", what, path);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+      void* mapped = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapped == MAP_FAILED) {
+        close(fd);
+        core_stop("Cannot map %s: %s", what, path);
+      }
+      bytes = static_cast<const char*>(mapped);
+    }
+    close(fd);  // the mapping stays valid
+#endif
+  }
+
+  ~MappedFile() {
+#ifdef _WIN32
+    if (bytes) {
+      UnmapViewOfFile(bytes);
+    }
+    if (mapping) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    if (bytes) {
+      munmap(const_cast<char*>(bytes), length);
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return bytes; }
+  size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_HPP
@@ -1,12 +1,12 @@
-#ifndef MINHASH_HPP
-#define MINHASH_HPP
-
 #include <Rcpp.h>
 #include <string>
 #include <vector>
-#include <unordered_set>
 #include <algorithm>
-#include <random>
+#include "minHash.hpp"
+#include "lshIndex.hpp"
+#include "packedSignatures.hpp"
+#include "sparseSimilarity.hpp"
+#include "similarityResult.hpp"
 
 // Add OpenMP if available
 #ifdef _OPENMP
@@ -17,93 +17,6 @@
 using namespace Rcpp;
 using namespace std;
 
-// MurmurHash3 implementation (remains largely the same)
-uint32_t murmur3_32(const char* key, size_t len, uint32_t seed) {
-  static const uint32_t c1 = 0xcc9e2d51;
-  static const uint32_t c2 = 0x1b873593;
-  static const uint32_t r1 = 15;
-  static const uint32_t r2 = 13;
-  static const uint32_t m = 5;
-  static const uint32_t n = 0xe6546b64;
-  
-  uint32_t hash = seed;
-  
-  const int nblocks = len / 4;
-  const uint32_t* blocks = reinterpret_cast<const uint32_t*>(key);
-  
-  for(int i = 0; i < nblocks; i++) {
-    uint32_t k = blocks[i];
-    k *= c1;
-    k = (k << r1) | (k >> (32 - r1));
-    k *= c2;
-    hash ^= k;
-    hash = ((hash << r2) | (hash >> (32 - r2))) * m + n;
-  }
-  
-  const uint8_t* tail = reinterpret_cast<const uint8_t*>(key + nblocks * 4);
-  uint32_t k1 = 0;
-  
-  switch(len & 3) {
-  case 3: k1 ^= tail[2] << 16;
-  case 2: k1 ^= tail[1] << 8;
-  case 1: k1 ^= tail[0];
-    k1 *= c1;
-    k1 = (k1 << r1) | (k1 >> (32 - r1));
-    k1 *= c2;
-    hash ^= k1;
-  }
-  
-  hash ^= len;
-  hash ^= (hash >> 16);
-  hash *= 0x85ebca6b;
-  hash ^= (hash >> 13);
-  hash *= 0xc2b2ae35;
-  hash ^= (hash >> 16);
-  
-  return hash;
-}
-
-// Enhanced Hash Family class with better seed generation
-class HashFamily {
-private:
-  vector<uint32_t> seeds;
-  
-public:
-  // Use random seed generation 
-  HashFamily(int num_hash, unsigned int seed = random_device{}()) {
-    seeds.resize(num_hash);
-    mt19937 gen(seed);
-    uniform_int_distribution<uint32_t> dis;
-    
-    for(int i = 0; i < num_hash; ++i) {
-      seeds[i] = dis(gen);
-    }
-  }
-  
-  uint32_t hash(const string& s, int index) const {
-    if (index < 0 || index >= static_cast<int>(seeds.size())) {
-      Rcpp::stop("Hash function index out of range");
-    }
-    return murmur3_32(s.c_str(), s.length(), seeds[index]);
-  }
-};
-
-// Generate k-mers from a sequence (with additional input validation)
-vector<string> generate_kmers(const string& seq, int k) {
-  vector<string> kmers;
-  if (k <= 0) {
-    Rcpp::warning("k must be a positive integer. Returning empty k-mer list.");
-    return kmers;
-  }
-  
-  if (seq.length() >= static_cast<size_t>(k)) {
-    for(size_t i = 0; i <= seq.length() - k; ++i) {
-      kmers.push_back(seq.substr(i, k));
-    }
-  }
-  return kmers;
-}
-
 //' @name similarityMH
 //' @title Compute MinHash Similarity Matrix
 //' 
@@ -113,10 +26,77 @@ vector<string> generate_kmers(const string& seq, int k) {
 //' @param sequences A character vector of input sequences
 //' @param k The length of k-mers to use (default: 4)
 //' @param n_hash Number of hash functions to use (default: 50)
-//' @return A numeric matrix of pairwise similarities
+//' @param method How signature slots are derived from the k-mers: `"mix"`
+//'        hashes each k-mer once and derives all slots by cheap mixing,
+//'        `"oph"` uses one permutation hashing with densification (fastest,
+//'        best suited to sequences with many more k-mers than `n_hash`),
+//'        `"classic"` hashes every k-mer string once per slot (default: "mix").
+//'        `"mix"` and `"oph"` read residues through the package alphabet:
+//'        lowercase letters count as their uppercase form, and every byte
+//'        other than a letter or `*` (gaps, digits, ...) counts as the same
+//'        unknown residue, whereas `"classic"` hashes the raw bytes.
+//' @param bits Bits kept per signature slot: 32 stores full minhashes, while
+//'        1, 2, 4, 8 or 16 store b-bit truncated minhashes (4-32 times less
+//'        memory, compared with vectorized kernels), with the b-bit estimate
+//'        bias-corrected as `(p - 2^-bits) / (1 - 2^-bits)` (default: 32)
+//' @param sparse If `TRUE`, return only the retained pairs as an edge list
+//'        instead of the dense matrix (default: FALSE)
+//' @param threshold Minimum similarity for a pair to be kept in sparse mode
+//'        (default: 0, i.e. every pair with non-zero similarity)
+//' @param top_k If positive, each sequence keeps only its `top_k` most similar
+//'        neighbours in sparse mode (default: 0, no limit)
+//' @param cut_quantile If given, the exact `cut_quantile` quantile of the
+//'        similarities of all pairs `i < j` is computed while they are filled
+//'        in, as `quantile(x[upper.tri(x)], cut_quantile)` would give, and
+//'        similarities below it are set to 0 (or dropped in sparse mode). The
+//'        cut is returned in `attr(, "threshold")` (default: NA, no cut)
+//' @param profile If `TRUE`, attach the wall time of each phase (`sketch`,
+//'        `compare`, `output`) and the counts of k-mers hashed, pairs
+//'        compared, threads and bytes allocated to the result as a named
+//'        numeric vector in `attr(, "profile")` (default: FALSE)
+//' @param dedup How identical sequences are handled: `"none"` compares every
+//'        sequence; `"expand"` compares each distinct sequence once and maps
+//'        the result back to all sequences, the same as comparing every copy
+//'        (`threshold`, `top_k` and `cut_quantile` apply to all pairs);
+//'        `"collapse"` returns the result for the distinct sequences, in
+//'        order of first occurrence, with their number of copies in
+//'        `attr(, "multiplicity")` and the row of each input sequence in
+//'        `attr(, "groups")`, as weighted nodes for clustering. Both add a
+//'        `dedup` phase to `profile` (default: "none")
+//' @param tile_path If given, compute out of core instead: the upper
+//'        triangle is computed tile by tile and every finished tile is
+//'        written to this file as match counts (one byte per pair up to 255
+//'        hash functions), for [readTileStore()] to read back. Rerunning with
+//'        the same sequences and parameters resumes an interrupted run,
+//'        reusing its seed. `sparse`, `threshold`, `top_k`, `cut_quantile`
+//'        and `profile` are ignored; `dedup` must be `"none"`
+//'        (default: "", in memory)
+//' @param memory_mb Memory budget of one tile in MiB with `tile_path`;
+//'        the signatures of all sequences are held in addition (default: 1024)
+//' @param type Storage of a dense result: `"double"`, `"integer"` (4 bytes)
+//'        or `"raw"` (1 byte), holding the similarity times `attr(, "scale")`
+//'        rounded; the scale is `n_hash` (at most 255 for raw), so with
+//'        `bits = 32` the entries count the agreeing slots exactly
+//'        (default: "double")
+//' @param packed If `TRUE`, return only the `n * (n - 1) / 2` pairs `i < j`
+//'        of a dense result as a vector, in the order of a `dist` object,
+//'        with `n` in `attr(, "n")` (default: FALSE)
+//' @param dimnames If `FALSE`, a full dense result has no row and column
+//'        names (default: TRUE)
+//' @return A numeric matrix of pairwise similarities, or with `sparse = TRUE`
+//'         a `sparse_similarity` data frame with 1-based columns `i < j` and
+//'         `score`, and the number of sequences in `attr(, "n")`. With
+//'         `tile_path`, the tile store description of [tileStoreInfo()]. See
+//'         `type` and `packed` for compact dense results
 //' @export
 // [[Rcpp::export]]
-NumericMatrix similarityMH(CharacterVector sequences, int k = 4, int n_hash = 50) {
+SEXP similarityMH(CharacterVector sequences, int k = 4, int n_hash = 50,
+                  std::string method = "mix", int bits = 32,
+                  bool sparse = false, double threshold = 0.0, int top_k = 0,
+                  double cut_quantile = NA_REAL, bool profile = false,
+                  std::string dedup = "none", std::string tile_path = "",
+                  double memory_mb = 1024, std::string type = "double", bool packed = false,
+                  bool dimnames = true) {
    // Comprehensive input validation
    if (sequences.length() == 0) {
      Rcpp::stop("Input sequences vector cannot be empty");
@@ -130,61 +110,157 @@ NumericMatrix similarityMH(CharacterVector sequences, int k = 4, int n_hash = 50
      Rcpp::stop("Number of hash functions must be positive");
    }
    
-   size_t n = sequences.length();
-   NumericMatrix similarityMatrix(n, n);
+   if (top_k < 0) {
+     Rcpp::stop("'top_k' must be a non-negative integer");
+   }
    
-   // Initialize hash family with random seed
-   HashFamily hash_family(n_hash);
+   if (!valid_signature_bits(bits)) {
+     Rcpp::stop("'bits' must be one of 1, 2, 4, 8, 16 or 32");
+   }
    
-   // Store signatures for each sequence
-   vector<vector<uint32_t>> signatures(n, vector<uint32_t>(n_hash, UINT32_MAX));
+   check_cut_quantile(cut_quantile);
+   DedupMode dedup_mode = parse_dedup(dedup);
+   DenseLayout layout = parse_dense_layout(type, packed, dimnames);
+   double memory_bytes = tile_memory_bytes(tile_path, memory_mb);
    
-   // Parallel processing of signature generation
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-   for(size_t i = 0; i < n; ++i) {
-     string seq = as<string>(sequences[i]);
-     vector<string> kmers = generate_kmers(seq, k);
-     
-     // For each k-mer, update signature
-     for(const string& kmer : kmers) {
-       for(int h = 0; h < n_hash; ++h) {
-         uint32_t hash_value = hash_family.hash(kmer, h);
-         signatures[i][h] = min(signatures[i][h], hash_value);
-       }
+   // Out of core: stream the pairs to a tile store
+   if (!tile_path.empty()) {
+     if (dedup_mode != DEDUP_NONE) {
+       Rcpp::stop("'dedup' must be \"none\" with 'tile_path'; tile the distinct sequences of "
+                  "collapseDuplicates() instead");
      }
+     tile_minhash(tile_path, as<vector<string>>(sequences), k, n_hash, parse_sketch_method(method),
+                  bits, memory_bytes, max_threads(), tile_interrupt);
+     return tile_store_info(tile_path);
    }
    
-   // Calculate similarities
-   for(size_t i = 0; i < n; ++i) {
-     similarityMatrix(i,i) = 1.0;  // Diagonal elements
-     
-     // Parallel processing of similarity computation
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-     for(size_t j = i+1; j < n; ++j) {
-       int matches = 0;
-       for(int h = 0; h < n_hash; ++h) {
-         if(signatures[i][h] == signatures[j][h]) {
-           ++matches;
-         }
-       }
-       double similarity = static_cast<double>(matches) / n_hash;
-       similarityMatrix(i,j) = similarity;
-       similarityMatrix(j,i) = similarity;
+   KernelProfile kernel_profile(profile);
+   
+   // Compare only distinct sequences when asked to
+   DuplicateIndex duplicates;
+   vector<string> seqs = dedup_sequences(as<vector<string>>(sequences), dedup_mode, duplicates,
+                                         kernel_profile);
+   kernel_profile.begin("sketch");
+   
+   // Initialize signature engine with random seed
+   MinHasher hasher(k, n_hash, parse_sketch_method(method));
+   
+   // Store signatures for each sequence
+   PackedSignatures signatures = compute_signatures(seqs, hasher, bits);
+   if (kernel_profile.active()) {
+     double kmers = 0.0;
+     for (const string& seq : seqs) {
+       kmers += seq.length() >= static_cast<size_t>(k) ? seq.length() - k + 1 : 0;
      }
+     kernel_profile.count("kmers_hashed", kmers);
    }
    
-   // Add dimension names (1,2,3...)
-   CharacterVector labels(n);
-   for(size_t i = 0; i < n; ++i) {
-     labels[i] = to_string(i + 1);
-   }
-   similarityMatrix.attr("dimnames") = List::create(labels, labels);
+   // Expanded results apply top_k and the layout to all pairs, after the expansion
+   bool expand = dedup_mode == DEDUP_EXPAND;
+   SEXP result = pairwise_signature_similarity(signatures, sparse, threshold, expand ? 0 : top_k,
+                                               cut_quantile, kernel_profile,
+                                               dedup_mode == DEDUP_NONE ? nullptr : &duplicates,
+                                               expand ? DEFAULT_LAYOUT : layout);
    
-   return similarityMatrix;
+   // Two copies of a sequence agree in every slot
+   vector<double> self_scores(seqs.size(), signatures.similarity_of(n_hash));
+   return kernel_profile.attach(dedup_result(result, dedup_mode, duplicates, self_scores,
+                                             threshold, top_k, layout,
+                                             result_scale(layout, n_hash)));
  }
 
-#endif // MINHASH_HPP
\ No newline at end of file
+//' @name similarityLSH
+//' @title Compute Sparse MinHash Similarities with an LSH Banding Index
+//' 
+//' @description
+//' This function computes MinHash similarities only for candidate pairs found
+//' by locality-sensitive hashing, avoiding the all-pairs comparison of
+//' `similarityMH`. Each signature of `bands * rows` hash values is cut into
+//' `bands` bands of `rows` values; sequences whose band values agree in at least
+//' one band land in the same bucket and become candidates, and the full
+//' signature agreement is then computed for those candidates only.
+//' 
+//' @details
+//' A pair with Jaccard similarity `s` becomes a candidate with probability
+//' `1 - (1 - s^rows)^bands`, so the recall curve is steepest around
+//' `(1 / bands)^(1 / rows)`. More bands (or fewer rows) raise recall at the
+//' cost of more candidate pairs.
+//' 
+//' A bucket holding more than `max_bucket` sequences (typically a band of
+//' low-complexity or heavily repeated sequences) would make that band
+//' quadratic again. Such a bucket only pairs its members that are fewer than
+//' `max_bucket` places apart in input order: every member still gets up to
+//' `2 * (max_bucket - 1)` neighbours from the bucket, but pairs further apart
+//' are only found through other bands. The number of capped buckets, summed
+//' over the bands, is returned in `attr(, "capped_buckets")`.
+//' 
+//' @param sequences A character vector of input sequences
+//' @param k The length of k-mers to use (default: 4)
+//' @param bands Number of LSH bands (default: 20)
+//' @param rows Number of signature values per band (default: 5)
+//' @param method Signature engine, as in `similarityMH` (default: "mix")
+//' @param bits Bits kept per signature slot, as in `similarityMH`; fewer bits
+//'        also make unrelated band values collide more often (default: 32)
+//' @param threshold Minimum similarity for a candidate pair to be kept
+//'        (default: 0, i.e. every candidate with non-zero similarity)
+//' @param top_k If positive, each sequence keeps only its `top_k` most similar
+//'        candidates (default: 0, no limit)
+//' @param max_bucket Largest bucket whose members are all paired, see
+//'        Details; 0 pairs every bucket in full (default: 1000)
+//' @param seed Seed of the hash functions, so that the candidates are
+//'        reproducible (default: 42)
+//' @return A `sparse_similarity` data frame with 1-based columns `i < j` and
+//'         `score`, the number of sequences in `attr(, "n")` and the number
+//'         of capped buckets in `attr(, "capped_buckets")`
+//' @export
+// [[Rcpp::export]]
+DataFrame similarityLSH(CharacterVector sequences, int k = 4, int bands = 20, int rows = 5,
+                        std::string method = "mix", int bits = 32,
+                        double threshold = 0.0, int top_k = 0,
+                        int max_bucket = 1000, int seed = 42) {
+  if (sequences.length() == 0) {
+    Rcpp::stop("Input sequences vector cannot be empty");
+  }
+  
+  if (k <= 0) {
+    Rcpp::stop("'k' must be a positive integer");
+  }
+  
+  if (bands <= 0 || rows <= 0) {
+    Rcpp::stop("'bands' and 'rows' must be positive integers");
+  }
+  
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  
+  if (!valid_signature_bits(bits)) {
+    Rcpp::stop("'bits' must be one of 1, 2, 4, 8, 16 or 32");
+  }
+  
+  if (max_bucket < 0) {
+    Rcpp::stop("'max_bucket' must be a non-negative integer");
+  }
+  
+  if (seed < 0) {
+    Rcpp::stop("'seed' must be a non-negative integer");
+  }
+  
+  size_t n = sequences.length();
+  int n_hash = bands * rows;
+  
+  MinHasher hasher(k, n_hash, parse_sketch_method(method), static_cast<unsigned int>(seed));
+  
+  vector<string> seqs = as<vector<string>>(sequences);
+  PackedSignatures signatures = compute_signatures(seqs, hasher, bits);
+  
+  SparseSimilarity edges(n, threshold, top_k);
+  size_t capped = for_each_lsh_candidate(signatures, bands, rows, max_bucket, 0,
+                                         [&](int i, int j) {
+    edges.add(i, j, signatures.similarity(i, j));
+  });
+  
+  DataFrame result = similarity_data_frame(edges);
+  result.attr("capped_buckets") = static_cast<double>(capped);
+  return result;
+}
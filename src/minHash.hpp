@@ -0,0 +1,368 @@
+#ifndef MINHASH_HPP
+#define MINHASH_HPP
+
+#include <string>
+#include <cstring>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <random>
+#include "alphabet.hpp"
+#include "packedSignatures.hpp"
+#include "sparseSimilarity.hpp"
+#include "coreError.hpp"
+#include "jobControl.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace std;
+
+// MurmurHash3 implementation (remains largely the same)
+inline uint32_t murmur3_32(const char* key, size_t len, uint32_t seed) {
+  static const uint32_t c1 = 0xcc9e2d51;
+  static const uint32_t c2 = 0x1b873593;
+  static const uint32_t r1 = 15;
+  static const uint32_t r2 = 13;
+  static const uint32_t m = 5;
+  static const uint32_t n = 0xe6546b64;
+  
+  uint32_t hash = seed;
+  
+  const int nblocks = len / 4;
+  
+  for(int i = 0; i < nblocks; i++) {
+    uint32_t k;
+    memcpy(&k, key + i * 4, sizeof(k));  // keys need not be aligned
+    k *= c1;
+    k = (k << r1) | (k >> (32 - r1));
+    k *= c2;
+    hash ^= k;
+    hash = ((hash << r2) | (hash >> (32 - r2))) * m + n;
+  }
+  
+  const uint8_t* tail = reinterpret_cast<const uint8_t*>(key + nblocks * 4);
+  uint32_t k1 = 0;
+  
+  switch(len & 3) {
+  case 3: k1 ^= tail[2] << 16;
+  case 2: k1 ^= tail[1] << 8;
+  case 1: k1 ^= tail[0];
+    k1 *= c1;
+    k1 = (k1 << r1) | (k1 >> (32 - r1));
+    k1 *= c2;
+    hash ^= k1;
+  }
+  
+  hash ^= len;
+  hash ^= (hash >> 16);
+  hash *= 0x85ebca6b;
+  hash ^= (hash >> 13);
+  hash *= 0xc2b2ae35;
+  hash ^= (hash >> 16);
+  
+  return hash;
+}
+
+// Enhanced Hash Family class with better seed generation
+class HashFamily {
+private:
+  vector<uint32_t> seeds;
+  
+public:
+  // Use random seed generation 
+  HashFamily(int num_hash, unsigned int seed = random_device{}()) {
+    seeds.resize(num_hash);
+    mt19937 gen(seed);
+    uniform_int_distribution<uint32_t> dis;
+    
+    for(int i = 0; i < num_hash; ++i) {
+      seeds[i] = dis(gen);
+    }
+  }
+  
+  uint32_t hash(const string& s, int index) const {
+    return hash(s.c_str(), s.length(), index);
+  }
+  
+  // `index` must be below the number of hash functions: this runs inside
+  // the parallel sketching loops, where nothing may be thrown
+  uint32_t hash(const char* s, size_t len, int index) const {
+    return murmur3_32(s, len, seeds[index]);
+  }
+};
+
+// Generate k-mers from a sequence (none when k is not positive)
+inline vector<string> generate_kmers(const string& seq, int k) {
+  vector<string> kmers;
+  if (k <= 0) {
+    return kmers;
+  }
+  
+  if (seq.length() >= static_cast<size_t>(k)) {
+    for(size_t i = 0; i <= seq.length() - k; ++i) {
+      kmers.push_back(seq.substr(i, k));
+    }
+  }
+  return kmers;
+}
+
+// 64-bit finalizer (splitmix64): spreads a k-mer code over all 64 bits
+inline uint64_t mix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// How the n_hash signature slots are derived from the k-mers of a sequence
+enum SketchMethod {
+  SKETCH_MIX,      // hash each k-mer once, derive every slot by multiply-shift
+  SKETCH_OPH,      // one permutation hashing: each k-mer fills one slot, then densify
+  SKETCH_CLASSIC   // one murmur3 hash of the k-mer string per slot
+};
+
+inline SketchMethod parse_sketch_method(const string& method) {
+  if (method == "mix") {
+    return SKETCH_MIX;
+  } else if (method == "oph") {
+    return SKETCH_OPH;
+  } else if (method == "classic") {
+    return SKETCH_CLASSIC;
+  }
+  core_stop("Invalid sketch method: %s (expected \"mix\", \"oph\" or \"classic\")", method);
+}
+
+inline const char* sketch_method_name(SketchMethod method) {
+  switch (method) {
+  case SKETCH_OPH: return "oph";
+  case SKETCH_CLASSIC: return "classic";
+  default: return "mix";
+  }
+}
+
+// MinHash signature engine
+//
+// The rolling engines encode residues with the compact alphabet, roll a k-mer
+// code across the sequence without allocating and hash each k-mer once with
+// mix64(). SKETCH_MIX then derives slot s as the high word of
+// mult[s] * h + add[s]; SKETCH_OPH uses the high word of h to pick a single
+// slot and fills the slots no k-mer hit by optimal densification, so its cost
+// is O(length + n_hash) per sequence.
+class MinHasher {
+private:
+  int k;
+  int n_hash;
+  SketchMethod method;
+  uint64_t kmer_seed;
+  vector<uint64_t> mult;
+  vector<uint64_t> add;
+  HashFamily hash_family;
+  
+  void sketch_classic(const string& seq, uint32_t* sig) const {
+    vector<string> kmers = generate_kmers(seq, k);
+    
+    // For each k-mer, update signature
+    for(const string& kmer : kmers) {
+      for(int h = 0; h < n_hash; ++h) {
+        uint32_t hash_value = hash_family.hash(kmer, h);
+        sig[h] = min(sig[h], hash_value);
+      }
+    }
+  }
+  
+  void sketch_mix(const string& seq, uint32_t* sig) const {
+    const uint64_t* a = mult.data();
+    const uint64_t* b = add.data();
+    const int slots = n_hash;
+    const uint64_t seed = kmer_seed;
+    for_each_kmer(seq, k, [=](uint64_t code) {
+      uint64_t h = mix64(code ^ seed);
+      for(int s = 0; s < slots; ++s) {
+        uint32_t v = static_cast<uint32_t>((a[s] * h + b[s]) >> 32);
+        sig[s] = v < sig[s] ? v : sig[s];
+      }
+    });
+  }
+  
+  void sketch_oph(const string& seq, uint32_t* sig) const {
+    vector<char> filled(n_hash, 0);
+    bool any = false;
+    const uint64_t slots = n_hash;
+    const uint64_t seed = kmer_seed;
+    for_each_kmer(seq, k, [&](uint64_t code) {
+      uint64_t h = mix64(code ^ seed);
+      size_t bin = static_cast<size_t>(((h >> 32) * slots) >> 32);
+      uint32_t v = static_cast<uint32_t>(h);
+      if(!filled[bin] || v < sig[bin]) {
+        sig[bin] = v;
+        filled[bin] = 1;
+      }
+      any = true;
+    });
+    if(!any) {
+      return;
+    }
+    
+    // Optimal densification: an empty slot copies the first non-empty slot on
+    // its own pseudo-random probe sequence, identical for every sequence
+    for(int s = 0; s < n_hash; ++s) {
+      if(filled[s]) {
+        continue;
+      }
+      for(uint64_t attempt = 1; ; ++attempt) {
+        size_t donor = static_cast<size_t>(
+          mix64(seed ^ (static_cast<uint64_t>(s) << 32) ^ attempt) % slots);
+        if(filled[donor]) {
+          sig[s] = sig[donor];
+          break;
+        }
+      }
+    }
+  }
+  
+public:
+  MinHasher(int k, int n_hash, SketchMethod method, unsigned int seed = random_device{}())
+    : k(k), n_hash(n_hash), method(method), mult(n_hash), add(n_hash),
+      hash_family(n_hash, seed) {
+    mt19937_64 gen(seed);
+    kmer_seed = gen();
+    for(int s = 0; s < n_hash; ++s) {
+      mult[s] = gen() | 1ULL;
+      add[s] = gen();
+    }
+  }
+  
+  int num_hash() const {
+    return n_hash;
+  }
+  
+  int kmer_length() const {
+    return k;
+  }
+  
+  // Slot s depends only on the seed and s for "mix" and "classic", so the
+  // first n slots of a signature are the signature with n_hash = n; "oph"
+  // spreads the k-mers over all n_hash slots and has no such prefixes
+  bool prefix_stable() const {
+    return method != SKETCH_OPH;
+  }
+  
+  // Fold the k-mer of `seq` starting at `start`, with the code
+  // for_each_kmer() gives it, into sig (prefix-stable methods only)
+  void add_kmer(const string& seq, size_t start, uint64_t code, uint32_t* sig) const {
+    if (method == SKETCH_CLASSIC) {
+      for(int h = 0; h < n_hash; ++h) {
+        uint32_t hash_value = hash_family.hash(seq.c_str() + start, k, h);
+        sig[h] = min(sig[h], hash_value);
+      }
+      return;
+    }
+    uint64_t h = mix64(code ^ kmer_seed);
+    for(int s = 0; s < n_hash; ++s) {
+      uint32_t v = static_cast<uint32_t>((mult[s] * h + add[s]) >> 32);
+      sig[s] = v < sig[s] ? v : sig[s];
+    }
+  }
+  
+  // Write the signature of `seq` into sig[0 .. n_hash); slots no k-mer
+  // reached stay at UINT32_MAX
+  void sketch(const string& seq, uint32_t* sig) const {
+    fill(sig, sig + n_hash, UINT32_MAX);
+    switch(method) {
+    case SKETCH_MIX:
+      sketch_mix(seq, sig);
+      break;
+    case SKETCH_OPH:
+      sketch_oph(seq, sig);
+      break;
+    case SKETCH_CLASSIC:
+      sketch_classic(seq, sig);
+      break;
+    }
+  }
+};
+
+// Compute the MinHash signature of every sequence (one row per sequence),
+// stored truncated to `bits` bits per slot; `n_threads` of 0 uses the
+// OpenMP default. With a `job`, every sketched sequence is reported to it
+// and the sequences left are skipped once it is stopped.
+inline PackedSignatures compute_signatures(const vector<string>& seqs, const MinHasher& hasher,
+                                           int bits = 32, int n_threads = 0,
+                                           JobControl* job = nullptr) {
+  size_t n = seqs.size();
+  PackedSignatures signatures(n, hasher.num_hash(), bits);
+  
+  // Parallel processing of signature generation
+#ifdef _OPENMP
+  if (n_threads <= 0) {
+    n_threads = omp_get_max_threads();
+  }
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    vector<uint32_t> sig(hasher.num_hash());
+#ifdef _OPENMP
+#pragma omp for
+#endif
+    for(size_t i = 0; i < n; ++i) {
+      if (job && job->stopped()) {
+        continue;
+      }
+      hasher.sketch(seqs[i], sig.data());
+      signatures.pack(i, sig.data());
+      if (job) {
+        job->advance(1);
+      }
+    }
+  }
+  return signatures;
+}
+
+// Signatures of several k-mer lengths at once: hashers[h] must share n_hash
+// and be prefix-stable, and row i of result h is what compute_signatures()
+// gives for hashers[h]. Each sequence is read once, with every length rolled
+// along the same pass.
+inline vector<PackedSignatures> compute_signatures_multi_k(const vector<string>& seqs,
+                                                           const vector<MinHasher>& hashers,
+                                                           int bits = 32, int n_threads = 0) {
+  size_t n = seqs.size();
+  size_t n_lengths = hashers.size();
+  int n_hash = n_lengths > 0 ? hashers[0].num_hash() : 0;
+  vector<int> ks(n_lengths);
+  vector<PackedSignatures> signatures;
+  for(size_t h = 0; h < n_lengths; ++h) {
+    if (hashers[h].num_hash() != n_hash || !hashers[h].prefix_stable()) {
+      core_stop("Multi-k sketching needs prefix-stable hashers with equal n_hash");
+    }
+    ks[h] = hashers[h].kmer_length();
+    signatures.push_back(PackedSignatures(n, n_hash, bits));
+  }
+  
+#ifdef _OPENMP
+  if (n_threads <= 0) {
+    n_threads = omp_get_max_threads();
+  }
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    vector<uint32_t> sig(n_lengths * n_hash);
+#ifdef _OPENMP
+#pragma omp for
+#endif
+    for(size_t i = 0; i < n; ++i) {
+      fill(sig.begin(), sig.end(), UINT32_MAX);
+      for_each_kmer_lengths(seqs[i], ks, [&](size_t h, size_t start, uint64_t code) {
+        hashers[h].add_kmer(seqs[i], start, code, &sig[h * n_hash]);
+      });
+      for(size_t h = 0; h < n_lengths; ++h) {
+        signatures[h].pack(i, &sig[h * n_hash]);
+      }
+    }
+  }
+  return signatures;
+}
+
+#endif // MINHASH_HPP
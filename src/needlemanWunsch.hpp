@@ -0,0 +1,620 @@
+#ifndef NEEDLEMAN_WUNSCH_HPP
+#define NEEDLEMAN_WUNSCH_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include "sparseSimilarity.hpp"
+#include "nwSimd.hpp"
+#include "pairScheduler.hpp"
+#include "coreError.hpp"
+
+using namespace std;
+
+// Amino acid to index mapping
+const map<char, int> aa_to_index = {
+  {'A', 0}, {'R', 1}, {'N', 2}, {'D', 3}, {'C', 4},
+  {'Q', 5}, {'E', 6}, {'G', 7}, {'H', 8}, {'I', 9},
+  {'L',10}, {'K',11}, {'M',12}, {'F',13}, {'P',14},
+  {'S',15}, {'T',16}, {'W',17}, {'Y',18}, {'V',19},
+  {'B',20}, {'Z',21}, {'X',22}, {'*', 23}
+};
+
+const int BLOSUM62[24][24] = {
+  { 4,-1,-2,-2, 0,-1,-1, 0,-2,-1,-1,-1,-1,-2,-1, 1, 0,-3,-2, 0,-2,-1, 0,-4}, // A
+  {-1, 5, 0,-2,-3, 1, 0,-2, 0,-3,-2, 2,-1,-3,-2,-1,-1,-3,-2,-3,-1, 0,-1,-4}, // R
+  {-2, 0, 6, 1,-3, 0, 0, 0, 1,-3,-3, 0,-2,-3,-2, 1, 0,-4,-2,-3, 3, 0,-1,-4}, // N
+  {-2,-2, 1, 6,-3, 0, 2,-1,-1,-3,-4,-1,-3,-3,-1, 0,-1,-4,-3,-3, 4, 1,-1,-4}, // D
+  { 0,-3,-3,-3, 9,-3,-4,-3,-3,-1,-1,-3,-1,-2,-3,-1,-1,-2,-2,-1,-3,-3,-2,-4}, // C
+  {-1, 1, 0, 0,-3, 5, 2,-2, 0,-3,-2, 1, 0,-3,-1, 0,-1,-2,-1,-2, 0, 3,-1,-4}, // Q
+  {-1, 0, 0, 2,-4, 2, 5,-2, 0,-3,-3, 1,-2,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1,-4}, // E
+  { 0,-2, 0,-1,-3,-2,-2, 6,-2,-4,-4,-2,-3,-3,-2, 0,-2,-2,-3,-3,-1,-2,-1,-4}, // G
+  {-2, 0, 1,-1,-3, 0, 0,-2, 8,-3,-3,-1,-2,-1,-2,-1,-2,-2, 2,-3, 0, 0,-1,-4}, // H
+  {-1,-3,-3,-3,-1,-3,-3,-4,-3, 4, 2,-3, 1, 0,-3,-2,-1,-3,-1, 3,-3,-3,-1,-4}, // I
+  {-1,-2,-3,-4,-1,-2,-3,-4,-3, 2, 4,-2, 2, 0,-3,-2,-1,-2,-1, 1,-4,-3,-1,-4}, // L
+  {-1, 2, 0,-1,-3, 1, 1,-2,-1,-3,-2, 5,-1,-3,-1, 0,-1,-3,-2,-2, 0, 1,-1,-4}, // K
+  {-1,-1,-2,-3,-1, 0,-2,-3,-2, 1, 2,-1, 5, 0,-2,-1,-1,-1,-1, 1,-3,-1,-1,-4}, // M
+  {-2,-3,-3,-3,-2,-3,-3,-3,-1, 0, 0,-3, 0, 6,-4,-2,-2, 1, 3,-1,-3,-3,-1,-4}, // F
+  {-1,-2,-2,-1,-3,-1,-1,-2,-2,-3,-3,-1,-2,-4, 7,-1,-1,-4,-3,-2,-2,-1,-2,-4}, // P
+  { 1,-1, 1, 0,-1, 0, 0, 0,-1,-2,-2, 0,-1,-2,-1, 4, 1,-3,-2,-2, 0, 0, 0,-4}, // S
+  { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-2,-1, 1, 5,-2,-2, 0,-1,-1, 0,-4}, // T
+  {-3,-3,-4,-4,-2,-2,-3,-2,-2,-3,-2,-3,-1, 1,-4,-3,-2,11, 2,-3,-4,-3,-2,-4}, // W
+  {-2,-2,-2,-3,-2,-1,-2,-3, 2,-1,-1,-2,-1, 3,-3,-2,-2, 2, 7,-1,-3,-2,-1,-4}, // Y
+  { 0,-3,-3,-3,-1,-2,-2,-3,-3, 3, 1,-2, 1,-1,-2,-2, 0,-3,-1, 4,-3,-2,-1,-4}, // V
+  {-2,-1, 3, 4,-3, 0, 1,-1, 0,-3,-4, 0,-3,-3,-2, 0,-1,-4,-3,-3, 4, 1,-1,-4}, // B
+  {-1, 0, 0, 1,-3, 3, 4,-2, 0,-3,-3, 1,-1,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1,-4}, // Z
+  { 0,-1,-1,-1,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-2, 0, 0,-2,-1,-1,-1,-1,-1,-4}, // X
+  {-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4, 1}  // *
+};
+
+
+const int BLOSUM45[24][24] = {
+  { 5,-2,-1,-2,-1,-1,-1, 0,-2,-1,-1,-1,-1,-2,-1, 1, 0,-2,-2, 0,-1,-1, 0,-5}, 
+  {-2, 7, 0,-1,-3, 1, 0,-2, 0,-3,-2, 3,-1,-2,-2,-1,-1,-2,-1,-2,-1, 0,-1,-5},
+  {-1, 0, 6, 2,-2, 0, 0, 0, 1,-2,-3, 0,-2,-2,-2, 1, 0,-4,-2,-3, 4, 0,-1,-5},
+  {-2,-1, 2, 7,-3, 0, 2,-1, 0,-4,-3, 0,-3,-4,-1, 0,-1,-4,-2,-3, 5, 1,-1,-5},
+  {-1,-3,-2,-3,12,-3,-3,-3,-3,-3,-2,-3,-2,-2,-4,-1,-1,-5,-3,-1,-2,-3,-2,-5},
+  {-1, 1, 0, 0,-3, 6, 2,-2, 1,-2,-2, 1, 0,-4,-1, 0,-1,-2,-1,-3, 0, 4,-1,-5},
+  {-1, 0, 0, 2,-3, 2, 6,-2, 0,-3,-2, 1,-2,-3, 0, 0,-1,-3,-2,-3, 1, 4,-1,-5},
+  { 0,-2, 0,-1,-3,-2,-2, 7,-2,-4,-3,-2,-2,-3,-2, 0,-2,-2,-3,-3,-1,-2,-1,-5},
+  {-2, 0, 1, 0,-3, 1, 0,-2,10,-3,-2,-1, 0,-2,-2,-1,-2,-3, 2,-3, 0, 0,-1,-5},
+  {-1,-3,-2,-4,-3,-2,-3,-4,-3, 5, 2,-3, 2, 0,-2,-2,-1,-2, 0, 3,-3,-3,-1,-5},
+  {-1,-2,-3,-3,-2,-2,-2,-3,-2, 2, 5,-3, 2, 1,-3,-3,-1,-2, 0, 1,-3,-2,-1,-5},
+  {-1, 3, 0, 0,-3, 1, 1,-2,-1,-3,-3, 5,-1,-3,-1,-1,-1,-2,-1,-2, 0, 1,-1,-5},
+  {-1,-1,-2,-3,-2, 0,-2,-2, 0, 2, 2,-1, 6, 0,-2,-2,-1,-2, 0, 1,-2,-1,-1,-5},
+  {-2,-2,-2,-4,-2,-4,-3,-3,-2, 0, 1,-3, 0, 8,-3,-2,-1, 1, 3, 0,-3,-3,-1,-5},
+  {-1,-2,-2,-1,-4,-1, 0,-2,-2,-2,-3,-1,-2,-3, 9,-1,-1,-3,-3,-3,-2,-1,-1,-5},
+  { 1,-1, 1, 0,-1, 0, 0, 0,-1,-2,-3,-1,-2,-2,-1, 4, 2,-4,-2,-1, 0, 0, 0,-5},
+  { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-1,-1, 2, 5,-3,-1, 0, 0,-1, 0,-5},
+  {-2,-2,-4,-4,-5,-2,-3,-2,-3,-2,-2,-2,-2, 1,-3,-4,-3,15, 3,-3,-4,-2,-2,-5},
+  {-2,-1,-2,-2,-3,-1,-2,-3, 2, 0, 0,-1, 0, 3,-3,-2,-1, 3, 8,-1,-2,-2,-1,-5},
+  { 0,-2,-3,-3,-1,-3,-3,-3,-3, 3, 1,-2, 1, 0,-3,-1, 0,-3,-1, 5,-3,-3,-1,-5},
+  {-1,-1, 4, 5,-2, 0, 1,-1, 0,-3,-3, 0,-2,-3,-2, 0, 0,-4,-2,-3, 5, 2,-1,-5},
+  {-1, 0, 0, 1,-3, 4, 4,-2, 0,-3,-2, 1,-1,-3,-1, 0,-1,-2,-2,-3, 2, 4,-1,-5},
+  { 0,-1,-1,-1,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 0, 0,-2,-1,-1,-1,-1,-1,-5},
+  {-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5, 1}
+};
+
+
+const int BLOSUM50[24][24] = {
+  { 5,-2,-1,-2,-1,-1,-1, 0,-2,-1,-2,-1,-1,-3,-1, 1, 0,-3,-2, 0,-2,-1,-1,-5},
+  {-2, 7,-1,-2,-4, 1, 0,-3, 0,-4,-3, 3,-2,-3,-3,-1,-1,-3,-1,-3,-1, 0,-1,-5},
+  {-1,-1, 7, 2,-2, 0, 0, 0, 1,-3,-4, 0,-2,-4,-2, 1, 0,-4,-2,-3, 4, 0,-1,-5},
+  {-2,-2, 2, 8,-4, 0, 2,-1,-1,-4,-4,-1,-4,-5,-1, 0,-1,-5,-3,-4, 5, 1,-1,-5},
+  {-1,-4,-2,-4,13,-3,-3,-3,-3,-2,-2,-3,-2,-2,-4,-1,-1,-5,-3,-1,-3,-3,-2,-5},
+  {-1, 1, 0, 0,-3, 7, 2,-2, 1,-3,-2, 2, 0,-4,-1, 0,-1,-1,-1,-3, 0, 4,-1,-5},
+  {-1, 0, 0, 2,-3, 2, 6,-3, 0,-4,-3, 1,-2,-3,-1,-1,-1,-3,-2,-3, 1, 5,-1,-5},
+  { 0,-3, 0,-1,-3,-2,-3, 8,-2,-4,-4,-2,-3,-4,-2, 0,-2,-3,-3,-4,-1,-2,-2,-5},
+  {-2, 0, 1,-1,-3, 1, 0,-2,10,-4,-3, 0,-1,-1,-2,-1,-2,-3, 2,-4, 0, 0,-1,-5},
+  {-1,-4,-3,-4,-2,-3,-4,-4,-4, 5, 2,-3, 2, 0,-3,-3,-1,-3,-1, 4,-4,-3,-1,-5},
+  {-2,-3,-4,-4,-2,-2,-3,-4,-3, 2, 5,-3, 3, 1,-4,-3,-1,-2,-1, 1,-4,-3,-1,-5},
+  {-1, 3, 0,-1,-3, 2, 1,-2, 0,-3,-3, 6,-2,-4,-1, 0,-1,-3,-2,-3, 0, 1,-1,-5},
+  {-1,-2,-2,-4,-2, 0,-2,-3,-1, 2, 3,-2, 7, 0,-3,-2,-1,-1, 0, 1,-3,-1,-1,-5},
+  {-3,-3,-4,-5,-2,-4,-3,-4,-1, 0, 1,-4, 0, 8,-4,-3,-2, 1, 4,-1,-4,-4,-2,-5},
+  {-1,-3,-2,-1,-4,-1,-1,-2,-2,-3,-4,-1,-3,-4,10,-1,-1,-4,-3,-3,-2,-1,-2,-5},
+  { 1,-1, 1, 0,-1, 0,-1, 0,-1,-3,-3, 0,-2,-3,-1, 5, 2,-4,-2,-2, 0, 0,-1,-5},
+  { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-2,-1, 2, 5,-3,-2, 0, 0,-1, 0,-5},
+  {-3,-3,-4,-5,-5,-1,-3,-3,-3,-3,-2,-3,-1, 1,-4,-4,-3,15, 2,-3,-5,-2,-3,-5},
+  {-2,-1,-2,-3,-3,-1,-2,-3, 2,-1,-1,-2, 0, 4,-3,-2,-2, 2, 8,-1,-3,-2,-1,-5},
+  { 0,-3,-3,-4,-1,-3,-3,-4,-4, 4, 1,-3, 1,-1,-3,-2, 0,-3,-1, 5,-4,-3,-1,-5},
+  {-2,-1, 4, 5,-3, 0, 1,-1, 0,-4,-4, 0,-3,-4,-2, 0, 0,-5,-3,-4, 5, 2,-1,-5},
+  {-1, 0, 0, 1,-3, 4, 5,-2, 0,-3,-3, 1,-1,-4,-1, 0,-1,-2,-2,-3, 2, 5,-1,-5},
+  {-1,-1,-1,-1,-2,-1,-1,-2,-1,-1,-1,-1,-1,-2,-2,-1, 0,-3,-1,-1,-1,-1,-1,-5},
+  {-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5, 1}
+};
+
+const int BLOSUM80[24][24] = {
+  { 7,-3,-3,-3,-1,-2,-2, 0,-3,-3,-3,-1,-2,-4,-1, 2, 0,-5,-4,-1,-3,-2,-1,-8},
+  {-3, 9,-1,-3,-6, 1,-1,-4, 0,-5,-4, 3,-3,-5,-3,-2,-2,-5,-4,-4,-2, 0,-2,-8},
+  {-3,-1, 9, 2,-5, 0,-1,-1, 1,-6,-6, 0,-4,-6,-4, 1, 0,-7,-4,-5, 5,-1,-2,-8},
+  {-3,-3, 2,10,-7,-1, 2,-3,-2,-7,-7,-2,-6,-6,-3,-1,-2,-8,-6,-6, 6, 1,-3,-8},
+  {-1,-6,-5,-7,13,-5,-7,-6,-7,-2,-3,-6,-3,-4,-6,-2,-2,-5,-5,-2,-6,-7,-4,-8},
+  {-2, 1, 0,-1,-5, 9, 3,-4, 1,-5,-4, 2,-1,-5,-3,-1,-1,-4,-3,-4,-1, 5,-2,-8},
+  {-2,-1,-1, 2,-7, 3, 8,-4, 0,-6,-6, 1,-4,-6,-2,-1,-2,-6,-5,-4, 1, 6,-2,-8},
+  { 0,-4,-1,-3,-6,-4,-4, 9,-4,-7,-7,-3,-5,-6,-5,-1,-3,-6,-6,-6,-2,-4,-3,-8},
+  {-3, 0, 1,-2,-7, 1, 0,-4,12,-6,-5,-1,-4,-2,-4,-2,-3,-4, 3,-5,-1, 0,-2,-8},
+  {-3,-5,-6,-7,-2,-5,-6,-7,-6, 7, 2,-5, 2,-1,-5,-4,-2,-5,-3, 4,-6,-6,-2,-8},
+  {-3,-4,-6,-7,-3,-4,-6,-7,-5, 2, 6,-4, 3, 0,-5,-4,-3,-4,-2, 1,-7,-5,-2,-8},
+  {-1, 3, 0,-2,-6, 2, 1,-3,-1,-5,-4, 8,-3,-5,-2,-1,-1,-6,-4,-4,-1, 1,-2,-8},
+  {-2,-3,-4,-6,-3,-1,-4,-5,-4, 2, 3,-3, 9, 0,-4,-3,-1,-3,-3, 1,-5,-3,-2,-8},
+  {-4,-5,-6,-6,-4,-5,-6,-6,-2,-1, 0,-5, 0,10,-6,-4,-4, 0, 4,-2,-6,-6,-3,-8},
+  {-1,-3,-4,-3,-6,-3,-2,-5,-4,-5,-5,-2,-4,-6,12,-2,-3,-7,-6,-4,-4,-2,-3,-8},
+  { 2,-2, 1,-1,-2,-1,-1,-1,-2,-4,-4,-1,-3,-4,-2, 7, 2,-6,-3,-3, 0,-1,-1,-8},
+  { 0,-2, 0,-2,-2,-1,-2,-3,-3,-2,-3,-1,-1,-4,-3, 2, 8,-5,-3, 0,-1,-2,-1,-8},
+  {-5,-5,-7,-8,-5,-4,-6,-6,-4,-5,-4,-6,-3, 0,-7,-6,-5,16, 3,-5,-8,-5,-5,-8},
+  {-4,-4,-4,-6,-5,-3,-5,-6, 3,-3,-2,-4,-3, 4,-6,-3,-3, 3,11,-3,-5,-4,-3,-8},
+  {-1,-4,-5,-6,-2,-4,-4,-6,-5, 4, 1,-4, 1,-2,-4,-3, 0,-5,-3, 7,-6,-4,-2,-8},
+  {-3,-2, 5, 6,-6,-1, 1,-2,-1,-6,-7,-1,-5,-6,-4, 0,-1,-8,-5,-6, 6, 0,-3,-8},
+  {-2, 0,-1, 1,-7, 5, 6,-4, 0,-6,-5, 1,-3,-6,-2,-1,-2,-5,-4,-4, 0, 6,-2,-8},
+  {-1,-2,-2,-3,-4,-2,-2,-3,-2,-2,-2,-2,-2,-3,-3,-1,-1,-5,-3,-2,-3,-2,-2,-8},
+  {-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8, 1}
+};
+
+
+const int BLOSUM90[24][24] = {
+  {5,-2,-2,-3,-1,-1,-1, 0,-2,-2,-2,-1,-2,-3,-1, 1, 0,-4,-3,-1,-2,-1,-1,-6},
+  {-2, 6,-1,-3,-5, 1,-1,-3, 0,-4,-3, 2,-2,-4,-3,-1,-2,-4,-3,-3,-2, 0,-2,-6},
+  {-2,-1, 7, 1,-4, 0,-1,-1, 0,-4,-4, 0,-3,-4,-3, 0, 0,-5,-3,-4, 4,-1,-2,-6},
+  {-3,-3, 1, 7,-5,-1, 1,-2,-2,-5,-5,-1,-4,-5,-3,-1,-2,-6,-4,-5, 4, 0,-2,-6},
+  {-1,-5,-4,-5, 9,-4,-6,-4,-5,-2,-2,-4,-2,-3,-4,-2,-2,-4,-4,-2,-4,-5,-3,-6},
+  {-1, 1, 0,-1,-4, 7, 2,-3, 1,-4,-3, 1, 0,-4,-2,-1,-1,-3,-3,-3,-1, 4,-1,-6},
+  {-1,-1,-1, 1,-6, 2, 6,-3,-1,-4,-4, 0,-3,-5,-2,-1,-1,-5,-4,-3, 0, 4,-2,-6},
+  { 0,-3,-1,-2,-4,-3,-3, 6,-3,-5,-5,-2,-4,-5,-3,-1,-3,-4,-5,-5,-2,-3,-2,-6},
+  {-2, 0, 0,-2,-5, 1,-1,-3, 8,-4,-4,-1,-3,-2,-3,-2,-2,-3, 1,-4,-1, 0,-2,-6},
+  {-2,-4,-4,-5,-2,-4,-4,-5,-4, 5, 1,-4, 1,-1,-4,-3,-1,-4,-2, 3,-5,-4,-2,-6},
+  {-2,-3,-4,-5,-2,-3,-4,-5,-4, 1, 5,-3, 2, 0,-4,-3,-2,-3,-2, 0,-5,-4,-2,-6},
+  {-1, 2, 0,-1,-4, 1, 0,-2,-1,-4,-3, 6,-2,-4,-2,-1,-1,-5,-3,-3,-1, 1,-1,-6},
+  {-2,-2,-3,-4,-2, 0,-3,-4,-3, 1, 2,-2, 7,-1,-3,-2,-1,-2,-2, 0,-4,-2,-1,-6},
+  {-3,-4,-4,-5,-3,-4,-5,-5,-2,-1, 0,-4,-1, 7,-4,-3,-3, 0, 3,-2,-4,-4,-2,-6},
+  {-1,-3,-3,-3,-4,-2,-2,-3,-3,-4,-4,-2,-3,-4, 8,-2,-2,-5,-4,-3,-3,-2,-2,-6},
+  { 1,-1, 0,-1,-2,-1,-1,-1,-2,-3,-3,-1,-2,-3,-2, 5, 1,-4,-3,-2, 0,-1,-1,-6},
+  { 0,-2, 0,-2,-2,-1,-1,-3,-2,-1,-2,-1,-1,-3,-2, 1, 6,-4,-2,-1,-1,-1,-1,-6},
+  {-4,-4,-5,-6,-4,-3,-5,-4,-3,-4,-3,-5,-2, 0,-5,-4,-4,11, 2,-3,-6,-4,-3,-6},
+  {-3,-3,-3,-4,-4,-3,-4,-5, 1,-2,-2,-3,-2, 3,-4,-3,-2, 2, 8,-3,-4,-3,-2,-6},
+  {-1,-3,-4,-5,-2,-3,-3,-5,-4, 3, 0,-3, 0,-2,-3,-2,-1,-3,-3, 5,-4,-3,-2,-6},
+  {-2,-2, 4, 4,-4,-1, 0,-2,-1,-5,-5,-1,-4,-4,-3, 0,-1,-6,-4,-4, 4, 0,-2,-6},
+  {-1, 0,-1, 0,-5, 4, 4,-3, 0,-4,-4, 1,-2,-4,-2,-1,-1,-4,-3,-3, 0, 4,-1,-6},
+  {-1,-2,-2,-2,-3,-1,-2,-2,-2,-2,-2,-1,-1,-2,-2,-1,-1,-3,-2,-2,-2,-1,-2,-6},
+  {-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6, 1}
+};
+
+const int BLOSUM100[24][24] = {
+  { 8,-3,-4,-5,-2,-2,-3,-1,-4,-4,-4,-2,-3,-5,-2, 1,-1,-6,-5,-2,-4,-2,-2,-10},
+  {-3,10,-2,-5,-8, 0,-2,-6,-1,-7,-6, 3,-4,-6,-5,-3,-3,-7,-5,-6,-4,-1,-3,-10},
+  {-4,-2,11, 1,-5,-1,-2,-2, 0,-7,-7,-1,-5,-7,-5, 0,-1,-8,-5,-7, 5,-2,-3,-10},
+  {-5,-5, 1,10,-8,-2, 2,-4,-3,-8,-8,-3,-8,-8,-5,-2,-4,-10,-7,-8, 6, 0,-4,-10},
+  {-2,-8,-5,-8,14,-7,-9,-7,-8,-3,-5,-8,-4,-4,-8,-3,-3,-7,-6,-3,-7,-8,-5,-10},
+  {-2, 0,-1,-2,-7,11, 2,-5, 1,-6,-5, 2,-2,-6,-4,-2,-3,-5,-4,-5,-2, 5,-2,-10},
+  {-3,-2,-2, 2,-9, 2,10,-6,-2,-7,-7, 0,-5,-8,-4,-2,-3,-8,-7,-5, 0, 7,-3,-10},
+  {-1,-6,-2,-4,-7,-5,-6, 9,-6,-9,-8,-5,-7,-8,-6,-2,-5,-7,-8,-8,-3,-5,-4,-10},
+  {-4,-1, 0,-3,-8, 1,-2,-6,13,-7,-6,-3,-5,-4,-5,-3,-4,-5, 1,-7,-2,-1,-4,-10},
+  {-4,-7,-7,-8,-3,-6,-7,-9,-7, 8, 2,-6, 1,-2,-7,-5,-3,-6,-4, 4,-8,-7,-3,-10},
+  {-4,-6,-7,-8,-5,-5,-7,-8,-6, 2, 8,-6, 3, 0,-7,-6,-4,-5,-4, 0,-8,-6,-3,-10},
+  {-2, 3,-1,-3,-8, 2, 0,-5,-3,-6,-6,10,-4,-6,-3,-2,-3,-8,-5,-5,-2, 0,-3,-10},
+  {-3,-4,-5,-8,-4,-2,-5,-7,-5, 1, 3,-4,12,-1,-5,-4,-2,-4,-5, 0,-7,-4,-3,-10},
+  {-5,-6,-7,-8,-4,-6,-8,-8,-4,-2, 0,-6,-1,11,-7,-5,-5, 0, 4,-3,-7,-7,-4,-10},
+  {-2,-5,-5,-5,-8,-4,-4,-6,-5,-7,-7,-3,-5,-7,12,-3,-4,-8,-7,-6,-5,-4,-4,-10},
+  { 1,-3, 0,-2,-3,-2,-2,-2,-3,-5,-6,-2,-4,-5,-3, 9, 2,-7,-5,-4,-1,-2,-2,-10},
+  {-1,-3,-1,-4,-3,-3,-3,-5,-4,-3,-4,-3,-2,-5,-4, 2, 9,-7,-5,-1,-2,-3,-2,-10},
+  {-6,-7,-8,-10,-7,-5,-8,-7,-5,-6,-5,-8,-4, 0,-8,-7,-7,17, 2,-5,-9,-7,-6,-10},
+  {-5,-5,-5,-7,-6,-4,-7,-8, 1,-4,-4,-5,-5, 4,-7,-5,-5, 2,12,-5,-6,-6,-4,-10},
+  {-2,-6,-7,-8,-3,-5,-5,-8,-7, 4, 0,-5, 0,-3,-6,-4,-1,-5,-5, 8,-7,-5,-3,-10},
+  {-4,-4, 5, 6,-7,-2, 0,-3,-2,-8,-8,-2,-7,-7,-5,-1,-2,-9,-6,-7, 6, 0,-4,-10},
+  {-2,-1,-2, 0,-8, 5, 7,-5,-1,-7,-6, 0,-4,-7,-4,-2,-3,-7,-6,-5, 0, 6,-2,-10},
+  {-2,-3,-3,-4,-5,-2,-3,-4,-4,-3,-3,-3,-3,-4,-4,-2,-2,-6,-4,-3,-4,-2,-3,-10},
+  {-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,1}
+};
+
+
+// Updated selection function
+inline const int (*getSubstitutionMatrix(std::string matrixName))[24] {
+  if (matrixName == "BLOSUM62") {
+    return BLOSUM62;
+  } else if (matrixName == "BLOSUM50") {
+    return BLOSUM50;
+  } else if (matrixName == "BLOSUM45") {
+    return BLOSUM45;
+  } else if (matrixName == "BLOSUM80") {
+    return BLOSUM80;
+  } else if (matrixName == "BLOSUM90") {
+    return BLOSUM90;
+  } else if (matrixName == "BLOSUM100") {
+    return BLOSUM100;
+  } else {
+    core_stop("Invalid substitution matrix name: %s", matrixName);
+  }
+}
+
+// Convert sequences to substitution matrix indices once, up front, so that
+// the alignment kernels never look up or reject residues inside parallel loops.
+// Errors number the sequences from `first` + 1.
+inline vector<vector<uint8_t>> encode_sequences(const vector<string>& sequences,
+                                                size_t first = 0) {
+  vector<vector<uint8_t>> encoded(sequences.size());
+  for (size_t s = 0; s < sequences.size(); ++s) {
+    const string& seq = sequences[s];
+    encoded[s].resize(seq.size());
+    for (size_t r = 0; r < seq.size(); ++r) {
+      auto it = aa_to_index.find(seq[r]);
+      if (it == aa_to_index.end()) {
+        core_stop("Invalid amino acid in sequence %lu: %c",
+                  static_cast<unsigned long>(first + s + 1), seq[r]);
+      }
+      encoded[s][r] = static_cast<uint8_t>(it->second);
+    }
+  }
+  return encoded;
+}
+
+// One DP cell: the affine-gap scores plus the number of matches and columns
+// of the traceback path that ends in this cell
+struct NWCell {
+  int M;
+  int Ix;
+  int Iy;
+  int matches;
+  int length;
+};
+
+// Two rolling DP rows of one thread, grown as needed and reused across pairs,
+// with running totals of the cells filled and the pairs abandoned early
+struct NWWorkspace {
+  vector<NWCell> prev;
+  vector<NWCell> cur;
+  uint64_t cells = 0;
+  uint64_t abandoned = 0;
+  
+  void reserve(size_t columns) {
+    if (prev.size() < columns) {
+      prev.resize(columns);
+      cur.resize(columns);
+    }
+  }
+};
+
+// Extra diagonals on each side of the band when its width is derived
+// automatically: 10% of the longer sequence, at least one
+inline long auto_band_width(size_t m, size_t n) {
+  return 1 + static_cast<long>(max(m, n) / 10);
+}
+
+// Needleman-Wunsch algorithm to calculate similarity
+//
+// Only two rows are kept. Instead of storing the traceback matrix, every cell
+// carries the match count and length of the path the traceback would follow
+// from it: a diagonal step extends the counters of (i-1, j-1), an up step
+// those of (i-1, j) and a left step those of (i, j-1). The counters at (m, n)
+// are exactly those of the full traceback, with the same tie-breaking.
+//
+// With `band >= 0` only cells whose diagonal j - i lies between the two
+// corner diagonals 0 and n - m, widened by `band` (or auto_band_width() when
+// band is 0), are filled; the rest are treated as unreachable.
+//
+// With `cutoff > 0` pairs whose similarity ends below `cutoff` report 0. The
+// final path leaves row i through one of its cells, and from (i, j) it can
+// gain at most min(m-i, n-j) matches over at least max(m-i, n-j) columns, so
+// a pair is abandoned as soon as no cell of a row can still reach the cutoff.
+inline double calculate_similarity(const vector<uint8_t> &sequence1, const vector<uint8_t> &sequence2,
+                                   const int substitutionMatrix[24][24],
+                                   int gapOpen, int gapExt, NWWorkspace &ws,
+                                   int band = -1, double cutoff = 0.0) {
+  size_t m = sequence1.size();
+  size_t n = sequence2.size();
+  const int NEG_INF = std::numeric_limits<int>::min() / 2;
+  const NWCell UNREACHABLE = {NEG_INF, NEG_INF, NEG_INF, 0, 0};
+  
+  // Range of diagonals j - i to fill
+  long diag_lo = -static_cast<long>(m);
+  long diag_hi = static_cast<long>(n);
+  if (band >= 0) {
+    long width = band > 0 ? band : auto_band_width(m, n);
+    long corner = static_cast<long>(n) - static_cast<long>(m);
+    diag_lo = min(0L, corner) - width;
+    diag_hi = max(0L, corner) + width;
+  }
+  
+  ws.reserve(n + 1);
+  NWCell *prev = ws.prev.data();
+  NWCell *cur = ws.cur.data();
+  
+  // Initialize first row (the first column is set row by row below)
+  size_t first_hi = static_cast<size_t>(min<long>(n, diag_hi));
+  prev[0].M = 0;
+  prev[0].Ix = prev[0].Iy = NEG_INF;
+  prev[0].matches = prev[0].length = 0;
+  for (size_t j = 1; j <= first_hi; ++j) {
+    prev[j].M = NEG_INF;
+    prev[j].Ix = NEG_INF;
+    prev[j].Iy = -gapOpen - (j - 1) * gapExt;
+    prev[j].matches = 0;
+    prev[j].length = j; // Left
+  }
+  if (first_hi < n) {
+    prev[first_hi + 1] = UNREACHABLE;
+  }
+  
+  // Fill rows, counting cells locally so the workspace is written once per pair
+  uint64_t cells = 0;
+  for (size_t i = 1; i <= m; ++i) {
+    uint8_t aa1 = sequence1[i - 1];
+    const int *scores = substitutionMatrix[aa1];
+    long row = static_cast<long>(i);
+    size_t lo = static_cast<size_t>(max(1L, row + diag_lo));
+    size_t hi = static_cast<size_t>(min(static_cast<long>(n), row + diag_hi));
+    
+    bool first_in_band = -row >= diag_lo;
+    if (first_in_band) {
+      cur[0].M = NEG_INF;
+      cur[0].Ix = -gapOpen - (i - 1) * gapExt;
+      cur[0].Iy = NEG_INF;
+      cur[0].matches = 0;
+      cur[0].length = i; // Up
+    } else {
+      cur[0] = UNREACHABLE;
+    }
+    // Neighbours just outside the band
+    if (lo > 1) {
+      cur[lo - 1] = UNREACHABLE;
+    }
+    if (hi < n) {
+      cur[hi + 1] = UNREACHABLE;
+    }
+    
+    cells += hi >= lo ? hi - lo + 1 : 0;
+    for (size_t j = lo; j <= hi; ++j) {
+      uint8_t aa2 = sequence2[j - 1];
+      const NWCell &up = prev[j];
+      const NWCell &diag = prev[j - 1];
+      const NWCell &left = cur[j - 1];
+      NWCell &cell = cur[j];
+      
+      // Compute Ix[i][j]
+      cell.Ix = std::max(up.M - (gapOpen + gapExt), up.Ix - gapExt);
+      
+      // Compute Iy[i][j]
+      cell.Iy = std::max(left.M - (gapOpen + gapExt), left.Iy - gapExt);
+      
+      // Compute M[i][j]
+      int score = scores[aa2];
+      int best = std::max({ diag.M, diag.Ix, diag.Iy }) + score;
+      
+      // Traceback step, applied to the path counters
+      if (best >= cell.Ix && best >= cell.Iy) {
+        cell.matches = diag.matches + (aa1 == aa2); // Diagonal
+        cell.length = diag.length + 1;
+      } else if (cell.Ix >= cell.Iy) {
+        best = cell.Ix;
+        cell.matches = up.matches; // Up
+        cell.length = up.length + 1;
+      } else {
+        best = cell.Iy;
+        cell.matches = left.matches; // Left
+        cell.length = left.length + 1;
+      }
+      cell.M = best;
+    }
+    
+    // Early termination: can any path through this row still reach the cutoff?
+    if (cutoff > 0.0) {
+      bool reachable = false;
+      for (size_t j = first_in_band ? 0 : lo; j <= hi && !reachable; ++j) {
+        size_t rest_i = m - i;
+        size_t rest_j = n - j;
+        double most = cur[j].matches + static_cast<double>(min(rest_i, rest_j));
+        double fewest = cur[j].length + static_cast<double>(max(rest_i, rest_j));
+        reachable = most >= cutoff * fewest;
+      }
+      if (!reachable) {
+        ws.cells += cells;
+        ++ws.abandoned;
+        return 0.0;
+      }
+    }
+    std::swap(prev, cur);
+  }
+  
+  ws.cells += cells;
+  
+  // Calculate similarity as number of matches divided by alignment length
+  double similarity = static_cast<double>(prev[n].matches) / prev[n].length;
+  if (similarity < cutoff) {
+    return 0.0;
+  }
+  return similarity;
+}
+
+// Largest absolute substitution score, used to bound the 16-bit engine
+inline int max_abs_score(const int substitutionMatrix[24][24]) {
+  int best = 0;
+  for (int a = 0; a < 24; ++a) {
+    for (int b = 0; b < 24; ++b) {
+      best = std::max(best, std::abs(substitutionMatrix[a][b]));
+    }
+  }
+  return best;
+}
+
+// The vectorized engine may align a pair with the sequences swapped, which
+// is only equivalent for symmetric substitution matrices
+inline bool is_symmetric(const int substitutionMatrix[24][24]) {
+  for (int a = 0; a < 24; ++a) {
+    for (int b = 0; b < a; ++b) {
+      if (substitutionMatrix[a][b] != substitutionMatrix[b][a]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Buffers of one thread of the vectorized engine
+struct NWBatchWorkspace {
+  vector<int16_t> profile;
+  vector<int16_t> residues;
+  vector<int16_t> rows;
+  vector<int16_t> prefer_up;
+  vector<size_t> target_len;
+  vector<int> matches;
+  vector<int> lengths;
+  NWWorkspace scalar;
+};
+
+// Queries of one target batch handled as a single scheduling unit
+struct NWBatchUnit {
+  size_t batch;
+  size_t p_begin;
+  size_t p_end;
+  double cost;
+};
+
+// Call visit(i, j, similarity) for every pair i < j using the inter-sequence
+// engine. Sequences are sorted by length and cut into batches of `lanes`
+// targets, so padding stays small; every shorter-or-equal sequence is then
+// aligned against each batch as the query, and each batch's query profile is
+// built once per unit. Pairs whose scores could exceed 16 bits go to the
+// scalar kernel. The result of every pair equals calculate_similarity with
+// the lower index as sequence1. A `job` is served per unit as in
+// for_each_pair_balanced().
+template <typename F>
+void for_each_pair_simd(const vector<vector<uint8_t>> &encoded,
+                        const int substitutionMatrix[24][24],
+                        int gapOpen, int gapExt, int n_threads,
+                        NWBatchKernel kernel, size_t lanes, F visit,
+                        JobControl* job = nullptr) {
+  size_t n = encoded.size();
+  const int max_abs = max_abs_score(substitutionMatrix);
+  
+  // Sort by length so each batch holds targets of similar size
+  vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return encoded[a].size() < encoded[b].size();
+  });
+  
+  // Work units: a target batch and a chunk of at most 64 queries before it
+  const size_t chunk = 64;
+  size_t n_batches = (n + lanes - 1) / lanes;
+  vector<NWBatchUnit> units;
+  for (size_t b = 0; b < n_batches; ++b) {
+    size_t batch_end = min(n, (b + 1) * lanes);
+    size_t width = encoded[order[batch_end - 1]].size();
+    for (size_t p_begin = 0; p_begin + 1 < batch_end; p_begin += chunk) {
+      NWBatchUnit unit = {b, p_begin, min(batch_end - 1, p_begin + chunk), 0.0};
+      for (size_t p = unit.p_begin; p < unit.p_end; ++p) {
+        unit.cost += static_cast<double>(encoded[order[p]].size() + 1) * (width + 1) * lanes;
+      }
+      units.push_back(unit);
+    }
+  }
+  stable_sort(units.begin(), units.end(),
+              [](const NWBatchUnit& a, const NWBatchUnit& b) { return a.cost > b.cost; });
+  
+  vector<NWBatchWorkspace> workspaces(n_threads);
+  long n_units = static_cast<long>(units.size());
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (long u = 0; u < n_units; ++u) {
+    const NWBatchUnit &unit = units[u];
+    NWBatchWorkspace &ws = workspaces[current_thread()];
+    size_t batch_begin = unit.batch * lanes;
+    size_t batch_end = min(n, batch_begin + lanes);
+    size_t width = encoded[order[batch_end - 1]].size();
+    uint64_t pairs = 0;
+    auto run = [&]() {
+      bool profile_ready = false;
+      
+      ws.prefer_up.assign(lanes, 0);
+      ws.target_len.assign(lanes, 0);
+      ws.matches.assign(lanes, 0);
+      ws.lengths.assign(lanes, 0);
+      for (size_t p = unit.p_begin; p < unit.p_end; ++p) {
+        size_t query = order[p];
+        size_t first_lane = p < batch_begin ? 0 : p + 1 - batch_begin;
+        
+        // Pairs too long for exact 16-bit scores use the scalar kernel
+        if (!nw_simd_fits(encoded[query].size(), width, gapOpen, gapExt, max_abs)) {
+          for (size_t l = first_lane; batch_begin + l < batch_end; ++l) {
+            size_t target = order[batch_begin + l];
+            size_t i = min(query, target);
+            size_t j = max(query, target);
+            visit(i, j, calculate_similarity(encoded[i], encoded[j], substitutionMatrix,
+                                             gapOpen, gapExt, ws.scalar));
+            ++pairs;
+          }
+          continue;
+        }
+        
+        // Query profile of the batch: substitution scores of every residue
+        // against each target column, one lane per target
+        if (!profile_ready) {
+          ws.profile.assign(24 * (width + 1) * lanes, 0);
+          ws.residues.assign((width + 1) * lanes, -1);
+          ws.rows.resize(2 * (width + 1) * 5 * lanes);
+          for (size_t l = 0; batch_begin + l < batch_end; ++l) {
+            const vector<uint8_t> &target = encoded[order[batch_begin + l]];
+            ws.target_len[l] = target.size();
+            for (size_t c = 0; c < target.size(); ++c) {
+              ws.residues[(c + 1) * lanes + l] = target[c];
+              for (int a = 0; a < 24; ++a) {
+                ws.profile[(a * (width + 1) + c + 1) * lanes + l] =
+                  static_cast<int16_t>(substitutionMatrix[a][target[c]]);
+              }
+            }
+          }
+          profile_ready = true;
+        }
+        
+        // A lane whose target has the lower index is the transposed alignment,
+        // where a gap in the query (Iy) must win ties instead of one in the target
+        for (size_t l = 0; batch_begin + l < batch_end; ++l) {
+          ws.prefer_up[l] = query < order[batch_begin + l] ? -1 : 0;
+        }
+        
+        NWBatchArgs args = {encoded[query].data(), encoded[query].size(),
+                            ws.profile.data(), ws.residues.data(), width,
+                            ws.prefer_up.data(), gapOpen, gapExt, ws.rows.data(),
+                            ws.target_len.data(), ws.matches.data(), ws.lengths.data()};
+        kernel(args);
+        
+        for (size_t l = first_lane; batch_begin + l < batch_end; ++l) {
+          size_t target = order[batch_begin + l];
+          visit(min(query, target), max(query, target),
+                static_cast<double>(ws.matches[l]) / ws.lengths[l]);
+          ++pairs;
+        }
+      }
+    };
+    if (job) {
+      job->guard(run);
+      job->advance(pairs);
+    } else {
+      run();
+    }
+  }
+}
+
+// Whether the vectorized engine can be used: it must be built for this
+// compiler, needs a symmetric matrix and always fills whole DP matrices
+inline bool nw_simd_available(const int substitutionMatrix[24][24], int band) {
+  int lanes = 0;
+  return select_nw_batch_kernel(lanes) != 0 && band < 0 && is_symmetric(substitutionMatrix);
+}
+
+// Call visit(i, j, similarity) for every pair i < j, with the vectorized
+// engine when `simd` is set (see nw_simd_available()) and with the
+// length-balanced scalar kernel otherwise, which uses one of `workspaces` per
+// thread. Similarities below `cutoff` are reported as 0; only the scalar
+// kernel also abandons such pairs early. A `job` tracks progress, stops the
+// remaining pairs and collects errors (see for_each_pair_balanced()).
+template <typename F>
+void for_each_alignment(const vector<vector<uint8_t>> &encoded,
+                        const int substitutionMatrix[24][24], int gapOpen, int gapExt,
+                        int band, double cutoff, bool simd, int n_threads,
+                        vector<NWWorkspace> &workspaces, F visit, JobControl* job = nullptr) {
+  if (simd) {
+    int lanes = 0;
+    NWBatchKernel kernel = select_nw_batch_kernel(lanes);
+    for_each_pair_simd(encoded, substitutionMatrix, gapOpen, gapExt, n_threads,
+                       kernel, lanes, [&](size_t i, size_t j, double similarity) {
+      visit(i, j, similarity < cutoff ? 0.0 : similarity);
+    }, job);
+    return;
+  }
+  vector<size_t> lengths(encoded.size());
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    lengths[i] = encoded[i].size();
+  }
+  for_each_pair_balanced(lengths, n_threads, [&](size_t i, size_t j, int thread) {
+    visit(i, j, calculate_similarity(encoded[i], encoded[j], substitutionMatrix,
+                                     gapOpen, gapExt, workspaces[thread], band, cutoff));
+  }, false, job);
+}
+
+#endif // NEEDLEMAN_WUNSCH_HPP
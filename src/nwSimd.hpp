@@ -0,0 +1,206 @@
+#ifndef NW_SIMD_HPP
+#define NW_SIMD_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+// Inter-sequence vectorized Needleman-Wunsch.
+//
+// One query is aligned against a batch of L targets at once, one target per
+// 16-bit vector lane. The kernel mirrors calculate_similarity cell for cell:
+// the affine-gap scores plus the match/length counters of the traceback path,
+// with the same tie-breaking. Targets are padded to the longest one in the
+// batch; a lane's result is read at its own target length, which padding
+// columns (to the right) never influence.
+//
+// Scores are plain (wrapping) 16-bit arithmetic with a sentinel of -2^14 for
+// impossible states. The caller must check nw_simd_fits() first: it bounds
+// every reachable score so that nothing wraps and sentinel-derived values
+// stay below every real one, which makes the 16-bit results exact.
+//
+// The kernel is written once with GCC/Clang generic vectors and instantiated
+// for 128-bit registers (any target) and for AVX2, picked at runtime.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DYNAALIGN_NW_SIMD 1
+#endif
+
+const int NW_SIMD_SENTINEL = -(1 << 14);
+
+// True when a query of length m against targets of at most `width` residues
+// can be scored exactly in 16-bit lanes
+inline bool nw_simd_fits(size_t m, size_t width, int gapOpen, int gapExt, int max_abs_score) {
+  long per_column = std::labs(gapOpen) + std::labs(gapExt) + max_abs_score;
+  long bound = static_cast<long>(m + width + 3) * per_column + max_abs_score;
+  return bound < (1L << 14);
+}
+
+// Inputs and outputs of one query-vs-batch alignment
+struct NWBatchArgs {
+  const uint8_t* query;       // encoded query residues
+  size_t m;                   // query length
+  const int16_t* profile;     // [24][width + 1][L] substitution scores per target column
+  const int16_t* residues;    // [width + 1][L] target residue codes (-1 for padding)
+  size_t width;               // longest target in the batch
+  const int16_t* prefer_up;   // [L] -1 where a gap in the target wins ties, else 0
+  int gapOpen;
+  int gapExt;
+  int16_t* rows;              // workspace: 2 rows x (width + 1) cells x 5 fields x L
+  const size_t* target_len;   // [L] target lengths
+  int* matches;               // [L] output: matches on the traceback path
+  int* lengths;               // [L] output: alignment lengths
+};
+
+typedef void (*NWBatchKernel)(const NWBatchArgs& args);
+
+#ifdef DYNAALIGN_NW_SIMD
+
+typedef int16_t nw_v8 __attribute__((vector_size(16)));
+typedef int16_t nw_v16 __attribute__((vector_size(32)));
+
+// mask ? a : b, lane by lane (mask lanes are all ones or all zeros)
+#define NW_SELECT(mask, a, b) (((mask) & (a)) | (~(mask) & (b)))
+
+// Kernel body, instantiated inside each target-specific wrapper below. Only
+// plain vector operators are used (comparisons yield all-ones lanes that
+// NW_SELECT blends with), so no helper ever passes a wide vector by value.
+template <typename V>
+inline __attribute__((always_inline)) void nw_batch_kernel(const NWBatchArgs& args) {
+  const size_t L = sizeof(V) / sizeof(int16_t);
+  const size_t stride = 5 * L;  // one cell: M, Ix, Iy, matches, length
+  const size_t width = args.width;
+  int16_t* prev = args.rows;
+  int16_t* cur = args.rows + (width + 1) * stride;
+
+  const V zero = V();
+  const V sentinel = zero + static_cast<int16_t>(NW_SIMD_SENTINEL);
+  const V gap_open = zero + static_cast<int16_t>(args.gapOpen + args.gapExt);
+  const V gap_ext = zero + static_cast<int16_t>(args.gapExt);
+  const V one = zero + static_cast<int16_t>(1);
+  V prefer_up;
+  std::memcpy(&prefer_up, args.prefer_up, sizeof(V));
+
+  // Initialize first row
+  V origin[5] = {zero, sentinel, sentinel, zero, zero};
+  std::memcpy(prev, origin, sizeof(origin));
+  for (size_t j = 1; j <= width; ++j) {
+    V cell[5] = {sentinel, sentinel,
+                 zero + static_cast<int16_t>(-args.gapOpen - static_cast<int>(j - 1) * args.gapExt),
+                 zero, zero + static_cast<int16_t>(j)};
+    std::memcpy(prev + j * stride, cell, sizeof(cell));
+  }
+
+  for (size_t i = 1; i <= args.m; ++i) {
+    const int16_t* scores = args.profile + args.query[i - 1] * (width + 1) * L;
+    const V query_residue = zero + static_cast<int16_t>(args.query[i - 1]);
+
+    // First column: gap in the target
+    V left_M = sentinel;
+    V left_Ix = zero + static_cast<int16_t>(-args.gapOpen - static_cast<int>(i - 1) * args.gapExt);
+    V left_Iy = sentinel;
+    V left_mat = zero;
+    V left_len = zero + static_cast<int16_t>(i);
+    V first[5] = {left_M, left_Ix, left_Iy, left_mat, left_len};
+    std::memcpy(cur, first, sizeof(first));
+
+    V diag_M, diag_Ix, diag_Iy, diag_mat, diag_len;
+    std::memcpy(&diag_M, prev, sizeof(V));
+    std::memcpy(&diag_Ix, prev + L, sizeof(V));
+    std::memcpy(&diag_Iy, prev + 2 * L, sizeof(V));
+    std::memcpy(&diag_mat, prev + 3 * L, sizeof(V));
+    std::memcpy(&diag_len, prev + 4 * L, sizeof(V));
+
+    for (size_t j = 1; j <= width; ++j) {
+      const int16_t* up = prev + j * stride;
+      V up_M, up_Ix, up_Iy, up_mat, up_len, score, residue;
+      std::memcpy(&up_M, up, sizeof(V));
+      std::memcpy(&up_Ix, up + L, sizeof(V));
+      std::memcpy(&up_Iy, up + 2 * L, sizeof(V));
+      std::memcpy(&up_mat, up + 3 * L, sizeof(V));
+      std::memcpy(&up_len, up + 4 * L, sizeof(V));
+      std::memcpy(&score, scores + j * L, sizeof(V));
+      std::memcpy(&residue, args.residues + j * L, sizeof(V));
+
+      V Ix_open = up_M - gap_open;
+      V Ix_ext = up_Ix - gap_ext;
+      V Ix = NW_SELECT(Ix_open > Ix_ext, Ix_open, Ix_ext);
+      V Iy_open = left_M - gap_open;
+      V Iy_ext = left_Iy - gap_ext;
+      V Iy = NW_SELECT(Iy_open > Iy_ext, Iy_open, Iy_ext);
+      V best = NW_SELECT(diag_M > diag_Ix, diag_M, diag_Ix);
+      best = NW_SELECT(best > diag_Iy, best, diag_Iy) + score;
+
+      // Traceback step: diagonal unless a gap state is strictly better,
+      // then the preferred gap on ties
+      V diagonal = ~((Ix > best) | (Iy > best));
+      V go_up = (Ix > Iy) | ((Ix == Iy) & prefer_up);
+      V is_match = residue == query_residue;
+
+      V gap = NW_SELECT(Ix > Iy, Ix, Iy);
+      V M = NW_SELECT(best > gap, best, gap);
+      V mat = NW_SELECT(diagonal, diag_mat - is_match, NW_SELECT(go_up, up_mat, left_mat));
+      V len = NW_SELECT(diagonal, diag_len, NW_SELECT(go_up, up_len, left_len)) + one;
+
+      int16_t* cell = cur + j * stride;
+      std::memcpy(cell, &M, sizeof(V));
+      std::memcpy(cell + L, &Ix, sizeof(V));
+      std::memcpy(cell + 2 * L, &Iy, sizeof(V));
+      std::memcpy(cell + 3 * L, &mat, sizeof(V));
+      std::memcpy(cell + 4 * L, &len, sizeof(V));
+
+      diag_M = up_M;
+      diag_Ix = up_Ix;
+      diag_Iy = up_Iy;
+      diag_mat = up_mat;
+      diag_len = up_len;
+      left_M = M;
+      left_Iy = Iy;
+      left_mat = mat;
+      left_len = len;
+    }
+    int16_t* swap = prev;
+    prev = cur;
+    cur = swap;
+  }
+
+  for (size_t l = 0; l < L; ++l) {
+    const int16_t* cell = prev + args.target_len[l] * stride;
+    args.matches[l] = cell[3 * L + l];
+    args.lengths[l] = cell[4 * L + l];
+  }
+}
+
+inline void nw_batch_generic(const NWBatchArgs& args) {
+  nw_batch_kernel<nw_v8>(args);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+inline void nw_batch_avx2(const NWBatchArgs& args) {
+  nw_batch_kernel<nw_v16>(args);
+}
+#endif
+
+#endif // DYNAALIGN_NW_SIMD
+
+// Pick the widest batch kernel the running CPU supports and report its lane
+// count; returns a null kernel (and 0 lanes) when no vector engine is built
+inline NWBatchKernel select_nw_batch_kernel(int& lanes) {
+#ifdef DYNAALIGN_NW_SIMD
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) {
+    lanes = 16;
+    return nw_batch_avx2;
+  }
+#endif
+  lanes = 8;
+  return nw_batch_generic;
+#else
+  lanes = 0;
+  return 0;
+#endif
+}
+
+#endif // NW_SIMD_HPP
@@ -0,0 +1,296 @@
+#ifndef PACKED_SIGNATURES_HPP
+#define PACKED_SIGNATURES_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Runtime-dispatched x86-64 kernels (GCC and Clang only; others use the scalar path)
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define DYNAALIGN_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// Mask with the lowest bit of every BITS-wide field of a 64-bit word set
+template <int BITS>
+inline uint64_t field_low_bits() {
+  uint64_t mask = 0;
+  for (int f = 0; f < 64; f += BITS) {
+    mask |= 1ULL << f;
+  }
+  return mask;
+}
+
+// Number of BITS-wide fields that differ between a and b, one word at a time
+template <int BITS>
+size_t mismatches_scalar(const uint64_t* a, const uint64_t* b, size_t words) {
+  const uint64_t low = field_low_bits<BITS>();
+  size_t count = 0;
+  for (size_t w = 0; w < words; ++w) {
+    uint64_t x = a[w] ^ b[w];
+    // Fold every field onto its lowest bit: non-zero iff the field differs
+    for (int s = 1; s < BITS; s <<= 1) {
+      x |= x >> s;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    count += __builtin_popcountll(x & low);
+#else
+    x &= low;
+    for (; x; x &= x - 1) {
+      ++count;
+    }
+#endif
+  }
+  return count;
+}
+
+#ifdef DYNAALIGN_X86_DISPATCH
+// AVX2: xor and fold four words at a time, popcount via nibble lookup
+template <int BITS>
+__attribute__((target("avx2")))
+size_t mismatches_avx2(const uint64_t* a, const uint64_t* b, size_t words) {
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  const __m256i low = _mm256_set1_epi64x(static_cast<long long>(field_low_bits<BITS>()));
+  __m256i total = _mm256_setzero_si256();
+  for (size_t w = 0; w < words; w += 4) {
+    __m256i x = _mm256_xor_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(a + w)),
+                                 _mm256_load_si256(reinterpret_cast<const __m256i*>(b + w)));
+    for (int s = 1; s < BITS; s <<= 1) {
+      x = _mm256_or_si256(x, _mm256_srl_epi64(x, _mm_cvtsi32_si128(s)));
+    }
+    x = _mm256_and_si256(x, low);
+    __m256i counts = _mm256_add_epi8(
+      _mm256_shuffle_epi8(lut, _mm256_and_si256(x, nibble)),
+      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble)));
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  }
+  return static_cast<size_t>(_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+                             _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+}
+
+// AVX-512: eight words at a time with the native 64-bit popcount
+template <int BITS>
+__attribute__((target("avx512f,avx512vpopcntdq")))
+size_t mismatches_avx512(const uint64_t* a, const uint64_t* b, size_t words) {
+  const __m512i low = _mm512_set1_epi64(static_cast<long long>(field_low_bits<BITS>()));
+  __m512i total = _mm512_setzero_si512();
+  for (size_t w = 0; w < words; w += 8) {
+    __m512i x = _mm512_xor_si512(_mm512_load_si512(a + w), _mm512_load_si512(b + w));
+    for (int s = 1; s < BITS; s <<= 1) {
+      x = _mm512_or_si512(x, _mm512_srl_epi64(x, _mm_cvtsi32_si128(s)));
+    }
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_and_si512(x, low)));
+  }
+  return static_cast<size_t>(_mm512_reduce_add_epi64(total));
+}
+#endif
+
+typedef size_t (*MismatchKernel)(const uint64_t*, const uint64_t*, size_t);
+
+// Pick the widest kernel the running CPU supports
+template <int BITS>
+MismatchKernel select_mismatch_kernel() {
+#ifdef DYNAALIGN_X86_DISPATCH
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")) {
+    return mismatches_avx512<BITS>;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return mismatches_avx2<BITS>;
+  }
+#endif
+  return mismatches_scalar<BITS>;
+}
+
+inline MismatchKernel select_mismatch_kernel(int bits) {
+  switch (bits) {
+  case 1: return select_mismatch_kernel<1>();
+  case 2: return select_mismatch_kernel<2>();
+  case 4: return select_mismatch_kernel<4>();
+  case 8: return select_mismatch_kernel<8>();
+  case 16: return select_mismatch_kernel<16>();
+  default: return select_mismatch_kernel<32>();
+  }
+}
+
+inline bool valid_signature_bits(int bits) {
+  return bits == 1 || bits == 2 || bits == 4 || bits == 8 || bits == 16 || bits == 32;
+}
+
+// 64-bit words per packed row: n_hash slots of `bits` bits, padded to whole
+// 64-byte cache lines
+inline size_t signature_row_words(int n_hash, int bits) {
+  size_t per_word = 64 / bits;
+  size_t words = (n_hash + per_word - 1) / per_word;
+  return (words + 7) / 8 * 8;
+}
+
+// MinHash similarity of two signatures of `n_hash` slots of `bits` bits that
+// agree on `agree` slots, with the b-bit estimate bias-corrected
+inline double signature_similarity(int agree, int n_hash, int bits) {
+  double p = static_cast<double>(agree) / n_hash;
+  if (bits >= 32) {
+    return p;
+  }
+  double chance = std::ldexp(1.0, -bits);
+  return std::max(0.0, (p - chance) / (1.0 - chance));
+}
+
+// Contiguous, cache-aligned matrix of b-bit MinHash signatures.
+//
+// Row i packs the n_hash slots of sequence i, truncated to their lowest `bits`
+// bits (1, 2, 4, 8, 16, or 32 for the full minhash), into 64-bit words. Rows
+// are padded with zero words to whole 64-byte cache lines, so every row is
+// aligned for vector loads and padding never counts as a mismatch.
+//
+// The rows either live in the object's own storage or, for a read-only view,
+// in an external 64-byte aligned block such as a memory-mapped file.
+class PackedSignatures {
+private:
+  size_t n;
+  int n_hash;
+  int bits;
+  size_t words;
+  std::vector<uint64_t> storage;
+  uint64_t* base;
+  MismatchKernel kernel;
+
+public:
+  PackedSignatures(size_t n, int n_hash, int bits = 32)
+    : n(n), n_hash(n_hash), bits(bits), words(signature_row_words(n_hash, bits)),
+      kernel(select_mismatch_kernel(bits)) {
+    storage.assign(n * words + 8, 0);
+    uintptr_t addr = reinterpret_cast<uintptr_t>(storage.data());
+    base = reinterpret_cast<uint64_t*>((addr + 63) & ~static_cast<uintptr_t>(63));
+  }
+
+  // Read-only view of n packed rows at `rows`; nothing is copied, and the
+  // block must outlive the view
+  PackedSignatures(size_t n, int n_hash, int bits, const uint64_t* rows)
+    : n(n), n_hash(n_hash), bits(bits), words(signature_row_words(n_hash, bits)),
+      base(const_cast<uint64_t*>(rows)), kernel(select_mismatch_kernel(bits)) {}
+
+  PackedSignatures(PackedSignatures&& other) = default;
+  PackedSignatures(const PackedSignatures&) = delete;
+  PackedSignatures& operator=(const PackedSignatures&) = delete;
+
+  size_t size() const { return n; }
+  int num_hash() const { return n_hash; }
+  int num_bits() const { return bits; }
+  size_t row_words() const { return words; }
+
+  const uint64_t* row(size_t i) const { return base + i * words; }
+  uint64_t* row(size_t i) { return base + i * words; }
+
+  // Copy of the listed rows, in that order
+  PackedSignatures subset(const std::vector<size_t>& rows) const {
+    PackedSignatures out(rows.size(), n_hash, bits);
+    for (size_t r = 0; r < rows.size(); ++r) {
+      std::copy(row(rows[r]), row(rows[r]) + words, out.row(r));
+    }
+    return out;
+  }
+
+  // Copy holding only the first `prefix_hash` slots of every row
+  PackedSignatures prefix(int prefix_hash) const {
+    PackedSignatures out(n, prefix_hash, bits);
+    const size_t per_word = 64 / bits;
+    const size_t full_words = prefix_hash / per_word;
+    const size_t rest = (prefix_hash % per_word) * bits;
+    for (size_t i = 0; i < n; ++i) {
+      std::copy(row(i), row(i) + full_words, out.row(i));
+      if (rest > 0) {
+        out.row(i)[full_words] = row(i)[full_words] & ((1ULL << rest) - 1);
+      }
+    }
+    return out;
+  }
+
+  // Store the full 32-bit signature `sig` as row i
+  void pack(size_t i, const uint32_t* sig) {
+    uint64_t* out = row(i);
+    const int per_word = 64 / bits;
+    const uint64_t value_mask = bits == 32 ? 0xffffffffULL : ((1ULL << bits) - 1);
+    for (int s = 0; s < n_hash; ++s) {
+      out[s / per_word] |= (sig[s] & value_mask) << ((s % per_word) * bits);
+    }
+  }
+
+  // The (truncated) value of slot s of row i
+  uint32_t slot(size_t i, int s) const {
+    const int per_word = 64 / bits;
+    const uint64_t value_mask = bits == 32 ? 0xffffffffULL : ((1ULL << bits) - 1);
+    return static_cast<uint32_t>((row(i)[s / per_word] >> ((s % per_word) * bits)) & value_mask);
+  }
+
+  int matches(size_t i, size_t j) const {
+    return matches(i, *this, j);
+  }
+
+  // Slots on which row i agrees with row j of `other`, which must have the
+  // same n_hash and bits (e.g. query signatures against a reference set)
+  int matches(size_t i, const PackedSignatures& other, size_t j) const {
+    return n_hash - static_cast<int>(kernel(row(i), other.row(j), words));
+  }
+
+  // Resemblance estimate. Two unrelated b-bit values agree with probability
+  // 2^-b, so the raw agreement p is corrected to (p - 2^-b) / (1 - 2^-b)
+  // (Li & Koenig, b-bit minwise hashing, sparse-data limit).
+  double similarity(size_t i, size_t j) const {
+    return similarity(i, *this, j);
+  }
+
+  double similarity(size_t i, const PackedSignatures& other, size_t j) const {
+    return similarity_of(matches(i, other, j));
+  }
+
+  // Similarity of a pair agreeing on `agree` slots; non-decreasing in `agree`,
+  // so a score distribution can be counted per number of matching slots
+  double similarity_of(int agree) const {
+    return signature_similarity(agree, n_hash, bits);
+  }
+};
+
+// Visit every pair i < j of n rows in square tiles, inside one parallel region.
+// Tiles hold `tile` rows so that both blocks of a tile pair stay in cache;
+// `n_threads` of 0 uses the OpenMP default.
+template <typename F>
+void for_each_pair_tiled(size_t n, size_t tile, F visit, int n_threads = 0) {
+  tile = std::max<size_t>(tile, 1);
+  long n_tiles = static_cast<long>((n + tile - 1) / tile);
+#ifdef _OPENMP
+  if (n_threads <= 0) {
+    n_threads = omp_get_max_threads();
+  }
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+  for (long bi = 0; bi < n_tiles; ++bi) {
+    size_t i_begin = bi * tile;
+    size_t i_end = std::min(n, i_begin + tile);
+    for (long bj = bi; bj < n_tiles; ++bj) {
+      size_t j_begin = bj * tile;
+      size_t j_end = std::min(n, j_begin + tile);
+      for (size_t i = i_begin; i < i_end; ++i) {
+        for (size_t j = std::max(j_begin, i + 1); j < j_end; ++j) {
+          visit(i, j);
+        }
+      }
+    }
+  }
+}
+
+// Rows per tile so that two tiles of signatures fit in a typical L2 cache
+inline size_t signature_tile_rows(const PackedSignatures& sigs) {
+  size_t row_bytes = sigs.row_words() * sizeof(uint64_t);
+  return std::min<size_t>(512, std::max<size_t>(8, (128 * 1024) / row_bytes));
+}
+
+#endif // PACKED_SIGNATURES_HPP
@@ -0,0 +1,140 @@
+#ifndef PAIR_SCHEDULER_HPP
+#define PAIR_SCHEDULER_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "sparseSimilarity.hpp"
+#include "coreError.hpp"
+#include "jobControl.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// Number of threads to use for a `threads` argument (0 means all available)
+inline int resolve_threads(int threads) {
+  if (threads < 0) {
+    core_stop("'threads' must be a non-negative integer");
+  }
+  return threads == 0 ? max_threads() : threads;
+}
+
+// A block of the upper triangle: rows [i_begin, i_end) x columns [j_begin, j_end)
+struct PairTile {
+  size_t i_begin;
+  size_t i_end;
+  size_t j_begin;
+  size_t j_end;
+  double cost;
+};
+
+// Split the pairs i < j (or i <= j with `diagonal`) of n items into square
+// tiles, most expensive first. The cost of a pair is the product of the two
+// item lengths, i.e. the size of its DP matrix; tile costs come from prefix
+// sums, so tiling takes O(n + tiles) rather than a pass over every pair.
+inline vector<PairTile> make_pair_tiles(const vector<size_t>& lengths, int n_threads,
+                                        bool diagonal = false) {
+  size_t n = lengths.size();
+
+  // Aim for about 16 tiles per thread so the tail of the schedule stays short
+  size_t per_side = static_cast<size_t>(std::sqrt(32.0 * max(n_threads, 1)));
+  size_t tile = min<size_t>(64, max<size_t>(1, n / max<size_t>(per_side, 1)));
+
+  // Prefix sums of the DP side lengths (length + 1) and of their squares
+  vector<double> sum(n + 1, 0.0);
+  vector<double> sum_sq(n + 1, 0.0);
+  for (size_t i = 0; i < n; ++i) {
+    double side = static_cast<double>(lengths[i] + 1);
+    sum[i + 1] = sum[i] + side;
+    sum_sq[i + 1] = sum_sq[i] + side * side;
+  }
+
+  vector<PairTile> tiles;
+  for (size_t i_begin = 0; i_begin < n; i_begin += tile) {
+    size_t i_end = min(n, i_begin + tile);
+    double rows = sum[i_end] - sum[i_begin];
+    for (size_t j_begin = i_begin; j_begin < n; j_begin += tile) {
+      size_t j_end = min(n, j_begin + tile);
+      PairTile t = {i_begin, i_end, j_begin, j_end, 0.0};
+      if (j_begin != i_begin) {
+        t.cost = rows * (sum[j_end] - sum[j_begin]);
+      } else if (diagonal || i_end - i_begin > 1) {
+        // Tiles on the diagonal hold the upper triangle of their block
+        double squares = sum_sq[i_end] - sum_sq[i_begin];
+        t.cost = (rows * rows + (diagonal ? squares : -squares)) / 2;
+      } else {
+        continue;  // a single item has no pair i < j
+      }
+      tiles.push_back(t);
+    }
+  }
+
+  // Longest-processing-time-first order for the dynamic schedule
+  stable_sort(tiles.begin(), tiles.end(),
+              [](const PairTile& a, const PairTile& b) { return a.cost > b.cost; });
+  return tiles;
+}
+
+// Call visit(i, j, thread) for every pair i < j (or i <= j with `diagonal`)
+// on n_threads threads. Tiles are handed out largest first, one at a time,
+// to whichever thread is idle, so long sequences do not stall the tail.
+// `thread` indexes per-thread state such as DP workspaces. With a `job`,
+// every finished tile is reported to it, the tiles left are skipped once it
+// is stopped, and errors are recorded in it instead of thrown.
+template <typename F>
+void for_each_pair_balanced(const vector<size_t>& lengths, int n_threads, F visit,
+                            bool diagonal = false, JobControl* job = nullptr) {
+  vector<PairTile> tiles = make_pair_tiles(lengths, n_threads, diagonal);
+  long n_tiles = static_cast<long>(tiles.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (long t = 0; t < n_tiles; ++t) {
+    const PairTile& tile = tiles[t];
+    int thread = current_thread();
+    uint64_t pairs = 0;
+    auto run = [&]() {
+      for (size_t i = tile.i_begin; i < tile.i_end; ++i) {
+        for (size_t j = max(tile.j_begin, diagonal ? i : i + 1); j < tile.j_end; ++j) {
+          visit(i, j, thread);
+          ++pairs;
+        }
+      }
+    };
+    if (job) {
+      job->guard(run);
+      job->advance(pairs);
+    } else {
+      run();
+    }
+  }
+}
+
+// Call visit(i, j, thread) for each listed pair on n_threads threads, most
+// expensive pairs first, in small chunks handed to whichever thread is idle
+template <typename F>
+void for_each_listed_pair(const vector<pair<int, int>>& pairs, const vector<size_t>& lengths,
+                          int n_threads, F visit) {
+  vector<pair<double, size_t>> order(pairs.size());
+  for (size_t p = 0; p < pairs.size(); ++p) {
+    double cost = static_cast<double>(lengths[pairs[p].first] + 1) * (lengths[pairs[p].second] + 1);
+    order[p] = make_pair(-cost, p);
+  }
+  sort(order.begin(), order.end());
+  long n_pairs = static_cast<long>(order.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) num_threads(n_threads)
+#endif
+  for (long p = 0; p < n_pairs; ++p) {
+    const pair<int, int>& listed = pairs[order[p].second];
+    visit(listed.first, listed.second, current_thread());
+  }
+}
+
+#endif // PAIR_SCHEDULER_HPP
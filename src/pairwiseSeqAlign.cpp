@@ -1,317 +1,15 @@
-#ifndef NW_HPP
-#define NW_HPP
-
 #include <Rcpp.h>
 #include <string>
 #include <vector>
-#include <map>
-#include <algorithm>
-#include <limits>
+#include <functional>
+#include "needlemanWunsch.hpp"
+#include "sparseSimilarity.hpp"
+#include "pairScheduler.hpp"
+#include "similarityResult.hpp"
 
 using namespace std;
 using namespace Rcpp;
 
-// Amino acid to index mapping
-const map<char, int> aa_to_index = {
-  {'A', 0}, {'R', 1}, {'N', 2}, {'D', 3}, {'C', 4},
-  {'Q', 5}, {'E', 6}, {'G', 7}, {'H', 8}, {'I', 9},
-  {'L',10}, {'K',11}, {'M',12}, {'F',13}, {'P',14},
-  {'S',15}, {'T',16}, {'W',17}, {'Y',18}, {'V',19},
-  {'B',20}, {'Z',21}, {'X',22}, {'*', 23}
-};
-
-const int BLOSUM62[24][24] = {
-  { 4,-1,-2,-2, 0,-1,-1, 0,-2,-1,-1,-1,-1,-2,-1, 1, 0,-3,-2, 0,-2,-1, 0,-4}, // A
-  {-1, 5, 0,-2,-3, 1, 0,-2, 0,-3,-2, 2,-1,-3,-2,-1,-1,-3,-2,-3,-1, 0,-1,-4}, // R
-  {-2, 0, 6, 1,-3, 0, 0, 0, 1,-3,-3, 0,-2,-3,-2, 1, 0,-4,-2,-3, 3, 0,-1,-4}, // N
-  {-2,-2, 1, 6,-3, 0, 2,-1,-1,-3,-4,-1,-3,-3,-1, 0,-1,-4,-3,-3, 4, 1,-1,-4}, // D
-  { 0,-3,-3,-3, 9,-3,-4,-3,-3,-1,-1,-3,-1,-2,-3,-1,-1,-2,-2,-1,-3,-3,-2,-4}, // C
-  {-1, 1, 0, 0,-3, 5, 2,-2, 0,-3,-2, 1, 0,-3,-1, 0,-1,-2,-1,-2, 0, 3,-1,-4}, // Q
-  {-1, 0, 0, 2,-4, 2, 5,-2, 0,-3,-3, 1,-2,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1,-4}, // E
-  { 0,-2, 0,-1,-3,-2,-2, 6,-2,-4,-4,-2,-3,-3,-2, 0,-2,-2,-3,-3,-1,-2,-1,-4}, // G
-  {-2, 0, 1,-1,-3, 0, 0,-2, 8,-3,-3,-1,-2,-1,-2,-1,-2,-2, 2,-3, 0, 0,-1,-4}, // H
-  {-1,-3,-3,-3,-1,-3,-3,-4,-3, 4, 2,-3, 1, 0,-3,-2,-1,-3,-1, 3,-3,-3,-1,-4}, // I
-  {-1,-2,-3,-4,-1,-2,-3,-4,-3, 2, 4,-2, 2, 0,-3,-2,-1,-2,-1, 1,-4,-3,-1,-4}, // L
-  {-1, 2, 0,-1,-3, 1, 1,-2,-1,-3,-2, 5,-1,-3,-1, 0,-1,-3,-2,-2, 0, 1,-1,-4}, // K
-  {-1,-1,-2,-3,-1, 0,-2,-3,-2, 1, 2,-1, 5, 0,-2,-1,-1,-1,-1, 1,-3,-1,-1,-4}, // M
-  {-2,-3,-3,-3,-2,-3,-3,-3,-1, 0, 0,-3, 0, 6,-4,-2,-2, 1, 3,-1,-3,-3,-1,-4}, // F
-  {-1,-2,-2,-1,-3,-1,-1,-2,-2,-3,-3,-1,-2,-4, 7,-1,-1,-4,-3,-2,-2,-1,-2,-4}, // P
-  { 1,-1, 1, 0,-1, 0, 0, 0,-1,-2,-2, 0,-1,-2,-1, 4, 1,-3,-2,-2, 0, 0, 0,-4}, // S
-  { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-2,-1, 1, 5,-2,-2, 0,-1,-1, 0,-4}, // T
-  {-3,-3,-4,-4,-2,-2,-3,-2,-2,-3,-2,-3,-1, 1,-4,-3,-2,11, 2,-3,-4,-3,-2,-4}, // W
-  {-2,-2,-2,-3,-2,-1,-2,-3, 2,-1,-1,-2,-1, 3,-3,-2,-2, 2, 7,-1,-3,-2,-1,-4}, // Y
-  { 0,-3,-3,-3,-1,-2,-2,-3,-3, 3, 1,-2, 1,-1,-2,-2, 0,-3,-1, 4,-3,-2,-1,-4}, // V
-  {-2,-1, 3, 4,-3, 0, 1,-1, 0,-3,-4, 0,-3,-3,-2, 0,-1,-4,-3,-3, 4, 1,-1,-4}, // B
-  {-1, 0, 0, 1,-3, 3, 4,-2, 0,-3,-3, 1,-1,-3,-1, 0,-1,-3,-2,-2, 1, 4,-1,-4}, // Z
-  { 0,-1,-1,-1,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-2, 0, 0,-2,-1,-1,-1,-1,-1,-4}, // X
-  {-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4,-4, 1}  // *
-};
-
-
-const int BLOSUM45[24][24] = {
-  { 5,-2,-1,-2,-1,-1,-1, 0,-2,-1,-1,-1,-1,-2,-1, 1, 0,-2,-2, 0,-1,-1, 0,-5}, 
-  {-2, 7, 0,-1,-3, 1, 0,-2, 0,-3,-2, 3,-1,-2,-2,-1,-1,-2,-1,-2,-1, 0,-1,-5},
-  {-1, 0, 6, 2,-2, 0, 0, 0, 1,-2,-3, 0,-2,-2,-2, 1, 0,-4,-2,-3, 4, 0,-1,-5},
-  {-2,-1, 2, 7,-3, 0, 2,-1, 0,-4,-3, 0,-3,-4,-1, 0,-1,-4,-2,-3, 5, 1,-1,-5},
-  {-1,-3,-2,-3,12,-3,-3,-3,-3,-3,-2,-3,-2,-2,-4,-1,-1,-5,-3,-1,-2,-3,-2,-5},
-  {-1, 1, 0, 0,-3, 6, 2,-2, 1,-2,-2, 1, 0,-4,-1, 0,-1,-2,-1,-3, 0, 4,-1,-5},
-  {-1, 0, 0, 2,-3, 2, 6,-2, 0,-3,-2, 1,-2,-3, 0, 0,-1,-3,-2,-3, 1, 4,-1,-5},
-  { 0,-2, 0,-1,-3,-2,-2, 7,-2,-4,-3,-2,-2,-3,-2, 0,-2,-2,-3,-3,-1,-2,-1,-5},
-  {-2, 0, 1, 0,-3, 1, 0,-2,10,-3,-2,-1, 0,-2,-2,-1,-2,-3, 2,-3, 0, 0,-1,-5},
-  {-1,-3,-2,-4,-3,-2,-3,-4,-3, 5, 2,-3, 2, 0,-2,-2,-1,-2, 0, 3,-3,-3,-1,-5},
-  {-1,-2,-3,-3,-2,-2,-2,-3,-2, 2, 5,-3, 2, 1,-3,-3,-1,-2, 0, 1,-3,-2,-1,-5},
-  {-1, 3, 0, 0,-3, 1, 1,-2,-1,-3,-3, 5,-1,-3,-1,-1,-1,-2,-1,-2, 0, 1,-1,-5},
-  {-1,-1,-2,-3,-2, 0,-2,-2, 0, 2, 2,-1, 6, 0,-2,-2,-1,-2, 0, 1,-2,-1,-1,-5},
-  {-2,-2,-2,-4,-2,-4,-3,-3,-2, 0, 1,-3, 0, 8,-3,-2,-1, 1, 3, 0,-3,-3,-1,-5},
-  {-1,-2,-2,-1,-4,-1, 0,-2,-2,-2,-3,-1,-2,-3, 9,-1,-1,-3,-3,-3,-2,-1,-1,-5},
-  { 1,-1, 1, 0,-1, 0, 0, 0,-1,-2,-3,-1,-2,-2,-1, 4, 2,-4,-2,-1, 0, 0, 0,-5},
-  { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-1,-1, 2, 5,-3,-1, 0, 0,-1, 0,-5},
-  {-2,-2,-4,-4,-5,-2,-3,-2,-3,-2,-2,-2,-2, 1,-3,-4,-3,15, 3,-3,-4,-2,-2,-5},
-  {-2,-1,-2,-2,-3,-1,-2,-3, 2, 0, 0,-1, 0, 3,-3,-2,-1, 3, 8,-1,-2,-2,-1,-5},
-  { 0,-2,-3,-3,-1,-3,-3,-3,-3, 3, 1,-2, 1, 0,-3,-1, 0,-3,-1, 5,-3,-3,-1,-5},
-  {-1,-1, 4, 5,-2, 0, 1,-1, 0,-3,-3, 0,-2,-3,-2, 0, 0,-4,-2,-3, 5, 2,-1,-5},
-  {-1, 0, 0, 1,-3, 4, 4,-2, 0,-3,-2, 1,-1,-3,-1, 0,-1,-2,-2,-3, 2, 4,-1,-5},
-  { 0,-1,-1,-1,-2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 0, 0,-2,-1,-1,-1,-1,-1,-5},
-  {-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5, 1}
-};
-
-
-const int BLOSUM50[24][24] = {
-  { 5,-2,-1,-2,-1,-1,-1, 0,-2,-1,-2,-1,-1,-3,-1, 1, 0,-3,-2, 0,-2,-1,-1,-5},
-  {-2, 7,-1,-2,-4, 1, 0,-3, 0,-4,-3, 3,-2,-3,-3,-1,-1,-3,-1,-3,-1, 0,-1,-5},
-  {-1,-1, 7, 2,-2, 0, 0, 0, 1,-3,-4, 0,-2,-4,-2, 1, 0,-4,-2,-3, 4, 0,-1,-5},
-  {-2,-2, 2, 8,-4, 0, 2,-1,-1,-4,-4,-1,-4,-5,-1, 0,-1,-5,-3,-4, 5, 1,-1,-5},
-  {-1,-4,-2,-4,13,-3,-3,-3,-3,-2,-2,-3,-2,-2,-4,-1,-1,-5,-3,-1,-3,-3,-2,-5},
-  {-1, 1, 0, 0,-3, 7, 2,-2, 1,-3,-2, 2, 0,-4,-1, 0,-1,-1,-1,-3, 0, 4,-1,-5},
-  {-1, 0, 0, 2,-3, 2, 6,-3, 0,-4,-3, 1,-2,-3,-1,-1,-1,-3,-2,-3, 1, 5,-1,-5},
-  { 0,-3, 0,-1,-3,-2,-3, 8,-2,-4,-4,-2,-3,-4,-2, 0,-2,-3,-3,-4,-1,-2,-2,-5},
-  {-2, 0, 1,-1,-3, 1, 0,-2,10,-4,-3, 0,-1,-1,-2,-1,-2,-3, 2,-4, 0, 0,-1,-5},
-  {-1,-4,-3,-4,-2,-3,-4,-4,-4, 5, 2,-3, 2, 0,-3,-3,-1,-3,-1, 4,-4,-3,-1,-5},
-  {-2,-3,-4,-4,-2,-2,-3,-4,-3, 2, 5,-3, 3, 1,-4,-3,-1,-2,-1, 1,-4,-3,-1,-5},
-  {-1, 3, 0,-1,-3, 2, 1,-2, 0,-3,-3, 6,-2,-4,-1, 0,-1,-3,-2,-3, 0, 1,-1,-5},
-  {-1,-2,-2,-4,-2, 0,-2,-3,-1, 2, 3,-2, 7, 0,-3,-2,-1,-1, 0, 1,-3,-1,-1,-5},
-  {-3,-3,-4,-5,-2,-4,-3,-4,-1, 0, 1,-4, 0, 8,-4,-3,-2, 1, 4,-1,-4,-4,-2,-5},
-  {-1,-3,-2,-1,-4,-1,-1,-2,-2,-3,-4,-1,-3,-4,10,-1,-1,-4,-3,-3,-2,-1,-2,-5},
-  { 1,-1, 1, 0,-1, 0,-1, 0,-1,-3,-3, 0,-2,-3,-1, 5, 2,-4,-2,-2, 0, 0,-1,-5},
-  { 0,-1, 0,-1,-1,-1,-1,-2,-2,-1,-1,-1,-1,-2,-1, 2, 5,-3,-2, 0, 0,-1, 0,-5},
-  {-3,-3,-4,-5,-5,-1,-3,-3,-3,-3,-2,-3,-1, 1,-4,-4,-3,15, 2,-3,-5,-2,-3,-5},
-  {-2,-1,-2,-3,-3,-1,-2,-3, 2,-1,-1,-2, 0, 4,-3,-2,-2, 2, 8,-1,-3,-2,-1,-5},
-  { 0,-3,-3,-4,-1,-3,-3,-4,-4, 4, 1,-3, 1,-1,-3,-2, 0,-3,-1, 5,-4,-3,-1,-5},
-  {-2,-1, 4, 5,-3, 0, 1,-1, 0,-4,-4, 0,-3,-4,-2, 0, 0,-5,-3,-4, 5, 2,-1,-5},
-  {-1, 0, 0, 1,-3, 4, 5,-2, 0,-3,-3, 1,-1,-4,-1, 0,-1,-2,-2,-3, 2, 5,-1,-5},
-  {-1,-1,-1,-1,-2,-1,-1,-2,-1,-1,-1,-1,-1,-2,-2,-1, 0,-3,-1,-1,-1,-1,-1,-5},
-  {-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5,-5, 1}
-};
-
-const int BLOSUM80[24][24] = {
-  { 7,-3,-3,-3,-1,-2,-2, 0,-3,-3,-3,-1,-2,-4,-1, 2, 0,-5,-4,-1,-3,-2,-1,-8},
-  {-3, 9,-1,-3,-6, 1,-1,-4, 0,-5,-4, 3,-3,-5,-3,-2,-2,-5,-4,-4,-2, 0,-2,-8},
-  {-3,-1, 9, 2,-5, 0,-1,-1, 1,-6,-6, 0,-4,-6,-4, 1, 0,-7,-4,-5, 5,-1,-2,-8},
-  {-3,-3, 2,10,-7,-1, 2,-3,-2,-7,-7,-2,-6,-6,-3,-1,-2,-8,-6,-6, 6, 1,-3,-8},
-  {-1,-6,-5,-7,13,-5,-7,-6,-7,-2,-3,-6,-3,-4,-6,-2,-2,-5,-5,-2,-6,-7,-4,-8},
-  {-2, 1, 0,-1,-5, 9, 3,-4, 1,-5,-4, 2,-1,-5,-3,-1,-1,-4,-3,-4,-1, 5,-2,-8},
-  {-2,-1,-1, 2,-7, 3, 8,-4, 0,-6,-6, 1,-4,-6,-2,-1,-2,-6,-5,-4, 1, 6,-2,-8},
-  { 0,-4,-1,-3,-6,-4,-4, 9,-4,-7,-7,-3,-5,-6,-5,-1,-3,-6,-6,-6,-2,-4,-3,-8},
-  {-3, 0, 1,-2,-7, 1, 0,-4,12,-6,-5,-1,-4,-2,-4,-2,-3,-4, 3,-5,-1, 0,-2,-8},
-  {-3,-5,-6,-7,-2,-5,-6,-7,-6, 7, 2,-5, 2,-1,-5,-4,-2,-5,-3, 4,-6,-6,-2,-8},
-  {-3,-4,-6,-7,-3,-4,-6,-7,-5, 2, 6,-4, 3, 0,-5,-4,-3,-4,-2, 1,-7,-5,-2,-8},
-  {-1, 3, 0,-2,-6, 2, 1,-3,-1,-5,-4, 8,-3,-5,-2,-1,-1,-6,-4,-4,-1, 1,-2,-8},
-  {-2,-3,-4,-6,-3,-1,-4,-5,-4, 2, 3,-3, 9, 0,-4,-3,-1,-3,-3, 1,-5,-3,-2,-8},
-  {-4,-5,-6,-6,-4,-5,-6,-6,-2,-1, 0,-5, 0,10,-6,-4,-4, 0, 4,-2,-6,-6,-3,-8},
-  {-1,-3,-4,-3,-6,-3,-2,-5,-4,-5,-5,-2,-4,-6,12,-2,-3,-7,-6,-4,-4,-2,-3,-8},
-  { 2,-2, 1,-1,-2,-1,-1,-1,-2,-4,-4,-1,-3,-4,-2, 7, 2,-6,-3,-3, 0,-1,-1,-8},
-  { 0,-2, 0,-2,-2,-1,-2,-3,-3,-2,-3,-1,-1,-4,-3, 2, 8,-5,-3, 0,-1,-2,-1,-8},
-  {-5,-5,-7,-8,-5,-4,-6,-6,-4,-5,-4,-6,-3, 0,-7,-6,-5,16, 3,-5,-8,-5,-5,-8},
-  {-4,-4,-4,-6,-5,-3,-5,-6, 3,-3,-2,-4,-3, 4,-6,-3,-3, 3,11,-3,-5,-4,-3,-8},
-  {-1,-4,-5,-6,-2,-4,-4,-6,-5, 4, 1,-4, 1,-2,-4,-3, 0,-5,-3, 7,-6,-4,-2,-8},
-  {-3,-2, 5, 6,-6,-1, 1,-2,-1,-6,-7,-1,-5,-6,-4, 0,-1,-8,-5,-6, 6, 0,-3,-8},
-  {-2, 0,-1, 1,-7, 5, 6,-4, 0,-6,-5, 1,-3,-6,-2,-1,-2,-5,-4,-4, 0, 6,-2,-8},
-  {-1,-2,-2,-3,-4,-2,-2,-3,-2,-2,-2,-2,-2,-3,-3,-1,-1,-5,-3,-2,-3,-2,-2,-8},
-  {-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8,-8, 1}
-};
-
-
-const int BLOSUM90[24][24] = {
-  {5,-2,-2,-3,-1,-1,-1, 0,-2,-2,-2,-1,-2,-3,-1, 1, 0,-4,-3,-1,-2,-1,-1,-6},
-  {-2, 6,-1,-3,-5, 1,-1,-3, 0,-4,-3, 2,-2,-4,-3,-1,-2,-4,-3,-3,-2, 0,-2,-6},
-  {-2,-1, 7, 1,-4, 0,-1,-1, 0,-4,-4, 0,-3,-4,-3, 0, 0,-5,-3,-4, 4,-1,-2,-6},
-  {-3,-3, 1, 7,-5,-1, 1,-2,-2,-5,-5,-1,-4,-5,-3,-1,-2,-6,-4,-5, 4, 0,-2,-6},
-  {-1,-5,-4,-5, 9,-4,-6,-4,-5,-2,-2,-4,-2,-3,-4,-2,-2,-4,-4,-2,-4,-5,-3,-6},
-  {-1, 1, 0,-1,-4, 7, 2,-3, 1,-4,-3, 1, 0,-4,-2,-1,-1,-3,-3,-3,-1, 4,-1,-6},
-  {-1,-1,-1, 1,-6, 2, 6,-3,-1,-4,-4, 0,-3,-5,-2,-1,-1,-5,-4,-3, 0, 4,-2,-6},
-  { 0,-3,-1,-2,-4,-3,-3, 6,-3,-5,-5,-2,-4,-5,-3,-1,-3,-4,-5,-5,-2,-3,-2,-6},
-  {-2, 0, 0,-2,-5, 1,-1,-3, 8,-4,-4,-1,-3,-2,-3,-2,-2,-3, 1,-4,-1, 0,-2,-6},
-  {-2,-4,-4,-5,-2,-4,-4,-5,-4, 5, 1,-4, 1,-1,-4,-3,-1,-4,-2, 3,-5,-4,-2,-6},
-  {-2,-3,-4,-5,-2,-3,-4,-5,-4, 1, 5,-3, 2, 0,-4,-3,-2,-3,-2, 0,-5,-4,-2,-6},
-  {-1, 2, 0,-1,-4, 1, 0,-2,-1,-4,-3, 6,-2,-4,-2,-1,-1,-5,-3,-3,-1, 1,-1,-6},
-  {-2,-2,-3,-4,-2, 0,-3,-4,-3, 1, 2,-2, 7,-1,-3,-2,-1,-2,-2, 0,-4,-2,-1,-6},
-  {-3,-4,-4,-5,-3,-4,-5,-5,-2,-1, 0,-4,-1, 7,-4,-3,-3, 0, 3,-2,-4,-4,-2,-6},
-  {-1,-3,-3,-3,-4,-2,-2,-3,-3,-4,-4,-2,-3,-4, 8,-2,-2,-5,-4,-3,-3,-2,-2,-6},
-  { 1,-1, 0,-1,-2,-1,-1,-1,-2,-3,-3,-1,-2,-3,-2, 5, 1,-4,-3,-2, 0,-1,-1,-6},
-  { 0,-2, 0,-2,-2,-1,-1,-3,-2,-1,-2,-1,-1,-3,-2, 1, 6,-4,-2,-1,-1,-1,-1,-6},
-  {-4,-4,-5,-6,-4,-3,-5,-4,-3,-4,-3,-5,-2, 0,-5,-4,-4,11, 2,-3,-6,-4,-3,-6},
-  {-3,-3,-3,-4,-4,-3,-4,-5, 1,-2,-2,-3,-2, 3,-4,-3,-2, 2, 8,-3,-4,-3,-2,-6},
-  {-1,-3,-4,-5,-2,-3,-3,-5,-4, 3, 0,-3, 0,-2,-3,-2,-1,-3,-3, 5,-4,-3,-2,-6},
-  {-2,-2, 4, 4,-4,-1, 0,-2,-1,-5,-5,-1,-4,-4,-3, 0,-1,-6,-4,-4, 4, 0,-2,-6},
-  {-1, 0,-1, 0,-5, 4, 4,-3, 0,-4,-4, 1,-2,-4,-2,-1,-1,-4,-3,-3, 0, 4,-1,-6},
-  {-1,-2,-2,-2,-3,-1,-2,-2,-2,-2,-2,-1,-1,-2,-2,-1,-1,-3,-2,-2,-2,-1,-2,-6},
-  {-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6,-6, 1}
-};
-
-const int BLOSUM100[24][24] = {
-  { 8,-3,-4,-5,-2,-2,-3,-1,-4,-4,-4,-2,-3,-5,-2, 1,-1,-6,-5,-2,-4,-2,-2,-10},
-  {-3,10,-2,-5,-8, 0,-2,-6,-1,-7,-6, 3,-4,-6,-5,-3,-3,-7,-5,-6,-4,-1,-3,-10},
-  {-4,-2,11, 1,-5,-1,-2,-2, 0,-7,-7,-1,-5,-7,-5, 0,-1,-8,-5,-7, 5,-2,-3,-10},
-  {-5,-5, 1,10,-8,-2, 2,-4,-3,-8,-8,-3,-8,-8,-5,-2,-4,-10,-7,-8, 6, 0,-4,-10},
-  {-2,-8,-5,-8,14,-7,-9,-7,-8,-3,-5,-8,-4,-4,-8,-3,-3,-7,-6,-3,-7,-8,-5,-10},
-  {-2, 0,-1,-2,-7,11, 2,-5, 1,-6,-5, 2,-2,-6,-4,-2,-3,-5,-4,-5,-2, 5,-2,-10},
-  {-3,-2,-2, 2,-9, 2,10,-6,-2,-7,-7, 0,-5,-8,-4,-2,-3,-8,-7,-5, 0, 7,-3,-10},
-  {-1,-6,-2,-4,-7,-5,-6, 9,-6,-9,-8,-5,-7,-8,-6,-2,-5,-7,-8,-8,-3,-5,-4,-10},
-  {-4,-1, 0,-3,-8, 1,-2,-6,13,-7,-6,-3,-5,-4,-5,-3,-4,-5, 1,-7,-2,-1,-4,-10},
-  {-4,-7,-7,-8,-3,-6,-7,-9,-7, 8, 2,-6, 1,-2,-7,-5,-3,-6,-4, 4,-8,-7,-3,-10},
-  {-4,-6,-7,-8,-5,-5,-7,-8,-6, 2, 8,-6, 3, 0,-7,-6,-4,-5,-4, 0,-8,-6,-3,-10},
-  {-2, 3,-1,-3,-8, 2, 0,-5,-3,-6,-6,10,-4,-6,-3,-2,-3,-8,-5,-5,-2, 0,-3,-10},
-  {-3,-4,-5,-8,-4,-2,-5,-7,-5, 1, 3,-4,12,-1,-5,-4,-2,-4,-5, 0,-7,-4,-3,-10},
-  {-5,-6,-7,-8,-4,-6,-8,-8,-4,-2, 0,-6,-1,11,-7,-5,-5, 0, 4,-3,-7,-7,-4,-10},
-  {-2,-5,-5,-5,-8,-4,-4,-6,-5,-7,-7,-3,-5,-7,12,-3,-4,-8,-7,-6,-5,-4,-4,-10},
-  { 1,-3, 0,-2,-3,-2,-2,-2,-3,-5,-6,-2,-4,-5,-3, 9, 2,-7,-5,-4,-1,-2,-2,-10},
-  {-1,-3,-1,-4,-3,-3,-3,-5,-4,-3,-4,-3,-2,-5,-4, 2, 9,-7,-5,-1,-2,-3,-2,-10},
-  {-6,-7,-8,-10,-7,-5,-8,-7,-5,-6,-5,-8,-4, 0,-8,-7,-7,17, 2,-5,-9,-7,-6,-10},
-  {-5,-5,-5,-7,-6,-4,-7,-8, 1,-4,-4,-5,-5, 4,-7,-5,-5, 2,12,-5,-6,-6,-4,-10},
-  {-2,-6,-7,-8,-3,-5,-5,-8,-7, 4, 0,-5, 0,-3,-6,-4,-1,-5,-5, 8,-7,-5,-3,-10},
-  {-4,-4, 5, 6,-7,-2, 0,-3,-2,-8,-8,-2,-7,-7,-5,-1,-2,-9,-6,-7, 6, 0,-4,-10},
-  {-2,-1,-2, 0,-8, 5, 7,-5,-1,-7,-6, 0,-4,-7,-4,-2,-3,-7,-6,-5, 0, 6,-2,-10},
-  {-2,-3,-3,-4,-5,-2,-3,-4,-4,-3,-3,-3,-3,-4,-4,-2,-2,-6,-4,-3,-4,-2,-3,-10},
-  {-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,-10,1}
-};
-
-
-// Updated selection function
-const int (*getSubstitutionMatrix(std::string matrixName))[24] {
-  if (matrixName == "BLOSUM62") {
-    return BLOSUM62;
-  } else if (matrixName == "BLOSUM50") {
-    return BLOSUM50;
-  } else if (matrixName == "BLOSUM45") {
-    return BLOSUM45;
-  } else if (matrixName == "BLOSUM80") {
-    return BLOSUM80;
-  } else if (matrixName == "BLOSUM90") {
-    return BLOSUM90;
-  } else if (matrixName == "BLOSUM100") {
-    return BLOSUM100;
-  } else {
-    Rcpp::stop("Invalid substitution matrix name: %s", matrixName);
-  }
-}
-
-// Needleman-Wunsch algorithm to calculate similarity
-double calculate_similarity(const string &sequence1, const string &sequence2,
-                            const int substitutionMatrix[24][24],
-                                                            int gapOpen = 10, int gapExt = 4) {
-  size_t m = sequence1.size();
-  size_t n = sequence2.size();
-  
-  // Initialize matrices
-  vector<vector<int>> M(m + 1, vector<int>(n + 1, std::numeric_limits<int>::min() / 2));
-  vector<vector<int>> Ix(m + 1, vector<int>(n + 1, std::numeric_limits<int>::min() / 2));
-  vector<vector<int>> Iy(m + 1, vector<int>(n + 1, std::numeric_limits<int>::min() / 2));
-  vector<vector<char>> traceback(m + 1, vector<char>(n + 1, '0'));
-  
-  // Initialize first row and column
-  M[0][0] = 0;
-  Ix[0][0] = Iy[0][0] = std::numeric_limits<int>::min() / 2;
-  for (size_t i = 1; i <= m; ++i) {
-    M[i][0] = std::numeric_limits<int>::min() / 2;
-    Ix[i][0] = -gapOpen - (i - 1) * gapExt;
-    Iy[i][0] = std::numeric_limits<int>::min() / 2;
-    traceback[i][0] = 'U'; // Up
-  }
-  for (size_t j = 1; j <= n; ++j) {
-    M[0][j] = std::numeric_limits<int>::min() / 2;
-    Ix[0][j] = std::numeric_limits<int>::min() / 2;
-    Iy[0][j] = -gapOpen - (j - 1) * gapExt;
-    traceback[0][j] = 'L'; // Left
-  }
-  
-  // Fill matrices
-  for (size_t i = 1; i <= m; ++i) {
-    char aa1 = sequence1[i - 1];
-    auto it1 = aa_to_index.find(aa1);
-    if (it1 == aa_to_index.end()) {
-      Rcpp::stop("Invalid amino acid in sequence1: %c", aa1);
-    }
-    int index1 = it1->second;
-    for (size_t j = 1; j <= n; ++j) {
-      char aa2 = sequence2[j - 1];
-      auto it2 = aa_to_index.find(aa2);
-      if (it2 == aa_to_index.end()) {
-        Rcpp::stop("Invalid amino acid in sequence2: %c", aa2);
-      }
-      int index2 = it2->second;
-      int score = substitutionMatrix[index1][index2];
-      
-      // Compute Ix[i][j]
-      int gapOpenX = M[i - 1][j] - (gapOpen + gapExt);
-      int gapExtX = Ix[i - 1][j] - gapExt;
-      Ix[i][j] = std::max(gapOpenX, gapExtX);
-      
-      // Compute Iy[i][j]
-      int gapOpenY = M[i][j - 1] - (gapOpen + gapExt);
-      int gapExtY = Iy[i][j - 1] - gapExt;
-      Iy[i][j] = std::max(gapOpenY, gapExtY);
-      
-      // Compute M[i][j]
-      int diagM = M[i - 1][j - 1] + score;
-      int diagIx = Ix[i - 1][j - 1] + score;
-      int diagIy = Iy[i - 1][j - 1] + score;
-      M[i][j] = std::max({ diagM, diagIx, diagIy });
-      
-      // Traceback
-      if (M[i][j] >= Ix[i][j] && M[i][j] >= Iy[i][j]) {
-        traceback[i][j] = 'D'; // Diagonal
-      } else if (Ix[i][j] >= Iy[i][j]) {
-        M[i][j] = Ix[i][j];
-        traceback[i][j] = 'U'; // Up
-      } else {
-        M[i][j] = Iy[i][j];
-        traceback[i][j] = 'L'; // Left
-      }
-    }
-  }
-  
-  // Backtracking to count matches and alignment length
-  int matches = 0;
-  int alignment_length = 0;
-  size_t i = m;
-  size_t j = n;
-  
-  while (i > 0 || j > 0) {
-    char tb = traceback[i][j];
-    if (tb == 'D') {
-      // Diagonal move
-      char a = sequence1[i - 1];
-      char b = sequence2[j - 1];
-      if (a == b) {
-        ++matches;
-      }
-      --i;
-      --j;
-    } else if (tb == 'U') {
-      // Up move (gap in sequence2)
-      --i;
-    } else { // 'L'
-      // Left move (gap in sequence1)
-      --j;
-    }
-    ++alignment_length;
-  }
-  
-  // Calculate similarity as number of matches divided by alignment length
-  double similarity = static_cast<double>(matches) / alignment_length;
-  return similarity;
-}
-
 //' @name similarityNW
 //' @title Sequence Alignment using Needleman-Wunsch Algorithm
 //' 
@@ -325,43 +23,269 @@ double calculate_similarity(const string &sequence1, const string &sequence2,
 //'        Options include `"BLOSUM62"`, `"BLOSUM45"`, `"BLOSUM50"`, and `"BLOSUM80"`
 //' @param gapOpen A numeric value specifying the penalty for opening a gap in the alignment
 //' @param gapExt A numeric value specifying the penalty for extending an existing gap
-//' @return A numeric matrix of pairwise similarities
+//' @param sparse If `TRUE`, return only the retained pairs as an edge list
+//'        instead of the dense matrix (default: FALSE)
+//' @param threshold Minimum similarity for a pair to be kept in sparse mode
+//'        (default: 0, i.e. every pair with non-zero similarity)
+//' @param top_k If positive, each sequence keeps only its `top_k` most similar
+//'        neighbours in sparse mode (default: 0, no limit)
+//' @param threads Number of threads used for the pairwise alignments
+//'        (default: 0, all available cores)
+//' @param engine Alignment backend: `"simd"` aligns each sequence against
+//'        8 or 16 others at once in 16-bit vector lanes (16 when the
+//'        CPU has AVX2), falling back to the scalar kernel for pairs whose
+//'        scores could overflow; `"scalar"` aligns one pair at a time.
+//'        Both give identical results (default: "simd")
+//' @param band Banded alignment: `-1` fills the full DP matrix, `0` keeps
+//'        the diagonals between the two corners plus 10% of the longer
+//'        sequence on each side, and a positive value uses that many extra
+//'        diagonals instead. Cost per pair becomes linear in sequence length;
+//'        the result is exact whenever the optimal path stays in the band.
+//'        Banded pairs always use the scalar kernel (default: -1)
+//' @param cutoff Similarity cutoff: pairs below it are reported as 0, and
+//'        alignments are abandoned as soon as they can no longer reach it.
+//'        In sparse mode `threshold` is applied the same way (default: 0)
+//' @param cut_quantile If given, the exact `cut_quantile` quantile of the
+//'        similarities of all pairs `i < j` is computed from the distinct
+//'        values counted while they are filled in, as
+//'        `quantile(x[upper.tri(x)], cut_quantile, na.rm = TRUE)` would
+//'        give (the NaN similarity of two empty sequences is left out), and
+//'        similarities below it are set to 0 (or dropped in sparse mode). The
+//'        cut is returned in `attr(, "threshold")` (default: NA, no cut)
+//' @param profile If `TRUE`, attach the wall time of each phase (`encode`,
+//'        `align`, `output`; the traceback is carried along with the DP
+//'        fill, so it has no phase of its own) and the counts of pairs
+//'        compared, DP cells filled, pairs abandoned below `cutoff`, threads
+//'        and bytes allocated to the result as a named numeric vector in
+//'        `attr(, "profile")` (default: FALSE)
+//' @param dedup How identical sequences are handled, as in [similarityMH()]:
+//'        `"none"`, `"expand"` (align each distinct sequence once, result for
+//'        all sequences) or `"collapse"` (result for the distinct sequences,
+//'        weighted by `attr(, "multiplicity")`) (default: "none")
+//' @param tile_path If given, compute out of core as in [similarityMH()]:
+//'        tiles of similarities in 16-bit fixed point (within 1e-5) are
+//'        written to this file, aligned with the scalar kernel under `band`
+//'        and `cutoff`; `engine` is ignored (default: "", in memory)
+//' @param memory_mb Memory budget of one tile in MiB with `tile_path`
+//'        (default: 1024)
+//' @param type Storage of a dense result: `"double"`, `"integer"` (4 bytes,
+//'        similarity times 65535 in `attr(, "scale")`) or `"raw"` (1 byte,
+//'        similarity times 255), each rounded; the NaN similarity of two empty
+//'        sequences becomes `NA` in integer results and 0 in raw ones
+//'        (default: "double")
+//' @param packed If `TRUE`, return only the `n * (n - 1) / 2` pairs `i < j`
+//'        of a dense result as a vector, in the order of a `dist` object,
+//'        with `n` in `attr(, "n")`; self-alignments are skipped
+//'        (default: FALSE)
+//' @param dimnames If `FALSE`, a full dense result has no row and column
+//'        names (default: TRUE)
+//' @return A numeric matrix of pairwise similarities, or with `sparse = TRUE`
+//'         a `sparse_similarity` data frame with 1-based columns `i < j` and
+//'         `score`, and the number of sequences in `attr(, "n")`. With
+//'         `tile_path`, the tile store description of [tileStoreInfo()]. See
+//'         `type` and `packed` for compact dense results
 //' @export
 // [[Rcpp::export]]
-NumericMatrix similarityNW(CharacterVector sequences,
-                                        std::string matrixName = "BLOSUM62",
-                                        int gapOpen = 10, int gapExt = 4) {
-  size_t n = sequences.length();
-  NumericMatrix similarityMatrix(n, n);
+SEXP similarityNW(CharacterVector sequences,
+                  std::string matrixName = "BLOSUM62",
+                  int gapOpen = 10, int gapExt = 4,
+                  bool sparse = false, double threshold = 0.0, int top_k = 0,
+                  int threads = 0, std::string engine = "simd",
+                  int band = -1, double cutoff = 0.0, double cut_quantile = NA_REAL,
+                  bool profile = false, std::string dedup = "none",
+                  std::string tile_path = "", double memory_mb = 1024,
+                  std::string type = "double", bool packed = false, bool dimnames = true) {
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  if (engine != "simd" && engine != "scalar") {
+    Rcpp::stop("Invalid engine: %s (expected \"simd\" or \"scalar\")", engine);
+  }
+  if (band < -1) {
+    Rcpp::stop("'band' must be -1 (no band), 0 (automatic) or a positive width");
+  }
+  if (cutoff < 0.0 || cutoff > 1.0) {
+    Rcpp::stop("'cutoff' must be between 0 and 1");
+  }
+  check_cut_quantile(cut_quantile);
+  DedupMode dedup_mode = parse_dedup(dedup);
+  DenseLayout layout = parse_dense_layout(type, packed, dimnames);
+  double memory_bytes = tile_memory_bytes(tile_path, memory_mb);
+  int n_threads = resolve_threads(threads);
+  
+  // Out of core: stream the pairs to a tile store
+  if (!tile_path.empty()) {
+    if (dedup_mode != DEDUP_NONE) {
+      Rcpp::stop("'dedup' must be \"none\" with 'tile_path'; tile the distinct sequences of "
+                 "collapseDuplicates() instead");
+    }
+    tile_alignments(tile_path, as<vector<string>>(sequences), matrixName, gapOpen, gapExt, band,
+                    cutoff, memory_bytes, n_threads, tile_interrupt);
+    return tile_store_info(tile_path);
+  }
+  bool cut = !ISNAN(cut_quantile);
+  ScoreTally tally(cut ? n_threads : 1);
+  KernelProfile kernel_profile(profile);
+  
+  // Compare only distinct sequences when asked to; each of their pairs then
+  // stands for duplicates.pairs(i, j) pairs of the input
+  DuplicateIndex duplicates;
+  vector<string> seqs = dedup_sequences(as<vector<string>>(sequences), dedup_mode, duplicates,
+                                        kernel_profile);
+  bool weighted = dedup_mode != DEDUP_NONE;
+  kernel_profile.begin("encode");
+  
+  // Pairs below the sparse threshold are dropped anyway, so stop aligning them early
+  if (sparse) {
+    cutoff = std::max(cutoff, threshold);
+  }
+  
+  size_t n = seqs.size();
   
   // Get the substitution matrix
   const int (*substitutionMatrix)[24] = getSubstitutionMatrix(matrixName);
-  // Calculate pairwise similarities
+  
+  // Convert every sequence once, outside the parallel region
+  vector<vector<uint8_t>> encoded = encode_sequences(seqs);
+  vector<size_t> lengths(n);
   for (size_t i = 0; i < n; ++i) {
-    string seq1 = as<string>(sequences[i]);
-    for (size_t j = i; j < n; ++j) {
-      string seq2 = as<string>(sequences[j]);
-      
-      // Get similarity
-      double similarity = calculate_similarity(seq1, seq2, substitutionMatrix, gapOpen, gapExt);
-      
-      // Assign similarity to matrix
-      similarityMatrix(i, j) = similarity;
-      similarityMatrix(j, i) = similarity; // Symmetric
+    lengths[i] = encoded[i].size();
+  }
+  vector<NWWorkspace> workspaces(n_threads);
+  kernel_profile.begin("align");
+  
+  // Score of two copies of a duplicated sequence, which are not aligned below
+  vector<double> self_scores(weighted ? n : 0, 0.0);
+  long n_distinct = static_cast<long>(self_scores.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+  for (long u = 0; u < n_distinct; ++u) {
+    if (duplicates.multiplicity[u] > 1) {
+      self_scores[u] = calculate_similarity(encoded[u], encoded[u], substitutionMatrix,
+                                            gapOpen, gapExt, workspaces[current_thread()],
+                                            band, cutoff);
     }
   }
+  auto tally_pair = [&](size_t i, size_t j, double similarity) {
+    tally.add(similarity, weighted ? duplicates.pairs(i, j) : 1);
+  };
+  auto tally_copies = [&]() {
+    for (long u = 0; u < n_distinct; ++u) {
+      if (duplicates.multiplicity[u] > 1) {
+        tally.add(self_scores[u], duplicates.pairs(u, u));
+      }
+    }
+  };
+  
+  // Results over the distinct sequences are mapped back at the end; expanded
+  // results apply top_k to all pairs, after the expansion
+  auto finish = [&](SEXP result) {
+    return kernel_profile.attach(dedup_result(result, dedup_mode, duplicates, self_scores,
+                                              threshold, top_k, layout,
+                                              result_scale(layout, NW_RESULT_SCALE)));
+  };
+  int kept_top_k = dedup_mode == DEDUP_EXPAND ? 0 : top_k;
+  
+  // Vectorized engine, when built for this compiler and valid for the matrix
+  bool use_simd = engine == "simd" && nw_simd_available(substitutionMatrix, band);
+  
+  // Run `visit(i, j, similarity)` over all pairs i < j with the chosen engine
+  auto for_each_pair = [&](std::function<void(size_t, size_t, double)> visit) {
+    for_each_alignment(encoded, substitutionMatrix, gapOpen, gapExt, band, cutoff, use_simd,
+                       n_threads, workspaces, visit);
+  };
   
-  // Add dimension names
-  // Create numeric labels 1,2,3...
-  CharacterVector labels(n);
-  for(size_t i = 0; i < n; ++i) {
-    labels[i] = std::to_string(i + 1);
+  // Profile counters of the alignment phase, which ends here. The vectorized
+  // engine always fills whole matrices, so its cells are counted from the
+  // lengths; the scalar kernel counts the cells it actually fills (fewer with
+  // a band or an early abandon), including the self-alignments on the diagonal.
+  auto count_alignments = [&]() {
+    if (!kernel_profile.active()) {
+      return;
+    }
+    double cells = 0.0, pruned = 0.0, bytes = 0.0;
+    if (use_simd) {
+      double total = 0.0, squares = 0.0;
+      for (size_t length : lengths) {
+        total += length;
+        squares += static_cast<double>(length) * length;
+      }
+      cells = (total * total - squares) / 2;
+    }
+    for (const NWWorkspace& ws : workspaces) {
+      cells += ws.cells;
+      pruned += ws.abandoned;
+      bytes += (ws.prev.capacity() + ws.cur.capacity()) * sizeof(NWCell);
+    }
+    for (size_t length : lengths) {
+      bytes += length;
+    }
+    kernel_profile.count("threads", n_threads);
+    kernel_profile.count("pairs_compared", static_cast<double>(n) * (n > 0 ? n - 1 : 0) / 2);
+    kernel_profile.count("dp_cells", cells);
+    kernel_profile.count("pairs_pruned", pruned);
+    kernel_profile.count("bytes_allocated", bytes);
+    kernel_profile.begin("output");
+  };
+  
+  // Sparse output: keep only the requested pairs, never allocating n x n
+  if (sparse) {
+    SparseSimilarity edges(n, threshold, kept_top_k, n_threads);
+    for_each_pair([&](size_t i, size_t j, double similarity) {
+      if (cut) {
+        tally_pair(i, j, similarity);
+      }
+      edges.add(i, j, similarity);
+    });
+    count_alignments();
+    kernel_profile.count("bytes_allocated", edges.bytes());
+    if (!cut) {
+      return finish(similarity_data_frame(edges));
+    }
+    tally_copies();
+    double q = score_quantile(tally.counts(), cut_quantile);
+    DataFrame out = similarity_data_frame(edges, ISNAN(q) ? 0.0 : q);
+    out.attr("threshold") = threshold_value(q);
+    return finish(out);
   }
   
-  // Add dimension names using numeric labels
-  similarityMatrix.attr("dimnames") = List::create(labels, labels);
+  // Filled in its final type; expanded results keep doubles until expansion
+  DenseLayout kept_layout = dedup_mode == DEDUP_EXPAND ? DEFAULT_LAYOUT : layout;
+  DenseSimilarity similarityMatrix(n, kept_layout, result_scale(kept_layout, NW_RESULT_SCALE));
   
-  return similarityMatrix;
+  // Calculate pairwise similarities
+  for_each_pair([&](size_t i, size_t j, double similarity) {
+    if (cut) {
+      tally_pair(i, j, similarity);
+    }
+    similarityMatrix.set(i, j, similarity);
+  });
+  
+  // Self-alignments on the diagonal, which packed results leave out
+  long n_diagonal = kept_layout.packed ? 0 : static_cast<long>(n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+  for (long i = 0; i < n_diagonal; ++i) {
+    similarityMatrix.set_diagonal(i, calculate_similarity(encoded[i], encoded[i], substitutionMatrix,
+                                                          gapOpen, gapExt,
+                                                          workspaces[current_thread()],
+                                                          band, cutoff));
+  }
+  count_alignments();
+  kernel_profile.count("bytes_allocated", similarityMatrix.size_bytes());
+  
+  // Cut at the quantile of the counted pair scores
+  RObject out = similarityMatrix.result();
+  if (cut) {
+    tally_copies();
+    double q = score_quantile(tally.counts(), cut_quantile);
+    if (!ISNAN(q)) {
+      similarityMatrix.cut(q);
+    }
+    out.attr("threshold") = threshold_value(q);
+  }
+  
+  return finish(out);
 }
-
-#endif
\ No newline at end of file
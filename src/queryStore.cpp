@@ -0,0 +1,196 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "minHash.hpp"
+#include "needlemanWunsch.hpp"
+#include "packedSignatures.hpp"
+#include "pairScheduler.hpp"
+#include "signatureStore.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// The best hits of one query: highest score first, ties to the lower
+// reference index. With a limit only the best `limit` hits are kept, in a
+// bounded heap whose top is the worst hit kept so far.
+class HitList {
+private:
+  size_t limit;
+  vector<pair<double, int>> hits;
+
+  static bool better(const pair<double, int>& a, const pair<double, int>& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  }
+
+public:
+  explicit HitList(size_t limit = 0) : limit(limit) {}
+
+  void offer(double score, int ref) {
+    pair<double, int> hit(score, ref);
+    if (limit == 0) {
+      hits.push_back(hit);
+    } else if (hits.size() < limit) {
+      hits.push_back(hit);
+      push_heap(hits.begin(), hits.end(), better);
+    } else if (better(hit, hits.front())) {
+      pop_heap(hits.begin(), hits.end(), better);
+      hits.back() = hit;
+      push_heap(hits.begin(), hits.end(), better);
+    }
+  }
+
+  // Hits in rank order
+  const vector<pair<double, int>>& sorted() {
+    sort(hits.begin(), hits.end(), better);
+    return hits;
+  }
+};
+
+//' @name queryStore
+//' @title Find Similar Reference Sequences for New Queries
+//'
+//' @description
+//' Compares each query sequence against every signature of a store built by
+//' [createSignatureStore()] and returns its best hits, without recomputing
+//' the similarities among the reference sequences. Queries are sketched with
+//' the parameters recorded in the store and processed in parallel, so the
+//' cost is proportional to the number of queries times the store size.
+//'
+//' When the reference `sequences` are supplied, the `candidates` best MinHash
+//' hits of each query are rescored with Needleman-Wunsch alignment, and
+//' `threshold` and `top_k` then apply to the alignment similarity.
+//'
+//' @param queries A character vector of query sequences
+//' @param path A store created by [createSignatureStore()]
+//' @param top_k Maximum number of hits per query; 0 keeps every hit
+//'        (default: 10)
+//' @param threshold Minimum similarity for a hit to be reported
+//'        (default: 0, i.e. every hit with non-zero similarity)
+//' @param sequences Optional character vector with the reference sequences
+//'        of the store, in store order, to rescore hits by alignment
+//'        (default: NULL, MinHash similarity only)
+//' @param candidates Number of MinHash hits per query aligned when
+//'        rescoring (default: 50)
+//' @param matrixName Substitution matrix for rescoring, see [similarityNW()]
+//'        (default: "BLOSUM62")
+//' @param gapOpen Penalty for opening a gap when rescoring (default: 10)
+//' @param gapExt Penalty for extending a gap when rescoring (default: 4)
+//' @param band Banded alignment width when rescoring, see [similarityNW()]
+//'        (default: -1, none)
+//' @param threads Number of threads (default: 0, all available cores)
+//' @return A data frame with one row per hit: the 1-based `query` and `ref`
+//'         (row of the store) indices and the similarity `score`, ordered by
+//'         query and then by decreasing score
+//' @export
+// [[Rcpp::export]]
+DataFrame queryStore(CharacterVector queries, std::string path, int top_k = 10,
+                     double threshold = 0.0,
+                     Rcpp::Nullable<Rcpp::CharacterVector> sequences = R_NilValue,
+                     int candidates = 50, std::string matrixName = "BLOSUM62",
+                     int gapOpen = 10, int gapExt = 4, int band = -1, int threads = 0) {
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  if (candidates <= 0) {
+    Rcpp::stop("'candidates' must be a positive integer");
+  }
+  if (band < -1) {
+    Rcpp::stop("'band' must be -1 (no band), 0 (automatic) or a positive width");
+  }
+  int n_threads = resolve_threads(threads);
+
+  SignatureStore store(path);
+  PackedSignatures reference = store.signatures();
+  size_t n_ref = reference.size();
+  bool rescore = sequences.isNotNull();
+
+  // Validate and encode everything the alignments need before any work
+  vector<string> query_seqs = as<vector<string>>(queries);
+  size_t n_query = query_seqs.size();
+  const int (*substitutionMatrix)[24] = 0;
+  vector<vector<uint8_t>> query_encoded, ref_encoded;
+  if (rescore) {
+    CharacterVector ref_seqs(sequences.get());
+    if (static_cast<size_t>(ref_seqs.length()) != n_ref) {
+      Rcpp::stop("'sequences' must hold the %d reference sequences of the store",
+                 static_cast<int>(n_ref));
+    }
+    substitutionMatrix = getSubstitutionMatrix(matrixName);
+    query_encoded = encode_sequences(query_seqs);
+    ref_encoded = encode_sequences(as<vector<string>>(ref_seqs));
+  }
+
+  PackedSignatures query_sigs = compute_signatures(query_seqs, store_hasher(store.header()),
+                                                   store.header().bits);
+
+  // MinHash stage: blocks of queries against cache-sized chunks of the
+  // reference, so each chunk is read once per block rather than per query
+  size_t limit = rescore ? candidates : top_k;
+  double mh_threshold = rescore ? 0.0 : threshold;
+  vector<HitList> lists(n_query, HitList(limit));
+  const size_t block = 16;
+  const size_t chunk = signature_tile_rows(reference);
+  long n_blocks = static_cast<long>((n_query + block - 1) / block);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+  for (long b = 0; b < n_blocks; ++b) {
+    size_t q_begin = b * block;
+    size_t q_end = min(n_query, q_begin + block);
+    for (size_t r_begin = 0; r_begin < n_ref; r_begin += chunk) {
+      size_t r_end = min(n_ref, r_begin + chunk);
+      for (size_t q = q_begin; q < q_end; ++q) {
+        for (size_t r = r_begin; r < r_end; ++r) {
+          double score = query_sigs.similarity(q, reference, r);
+          if (score > 0.0 && score >= mh_threshold) {
+            lists[q].offer(score, static_cast<int>(r));
+          }
+        }
+      }
+    }
+  }
+
+  // Alignment stage: rescore each query's candidates and rank them again
+  if (rescore) {
+    vector<NWWorkspace> workspaces(n_threads);
+    long n_queries = static_cast<long>(n_query);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+    for (long q = 0; q < n_queries; ++q) {
+      NWWorkspace& workspace = workspaces[current_thread()];
+      HitList rescored(top_k);
+      for (const pair<double, int>& hit : lists[q].sorted()) {
+        double score = calculate_similarity(query_encoded[q], ref_encoded[hit.second],
+                                            substitutionMatrix, gapOpen, gapExt, workspace,
+                                            band, threshold);
+        if (score > 0.0 && score >= threshold) {
+          rescored.offer(score, hit.second);
+        }
+      }
+      lists[q] = rescored;
+    }
+  }
+
+  // Gather the hits in query order
+  vector<int> col_query, col_ref;
+  vector<double> col_score;
+  for (size_t q = 0; q < n_query; ++q) {
+    for (const pair<double, int>& hit : lists[q].sorted()) {
+      col_query.push_back(static_cast<int>(q) + 1);
+      col_ref.push_back(hit.second + 1);
+      col_score.push_back(hit.first);
+    }
+  }
+  return DataFrame::create(Named("query") = wrap(col_query),
+                           Named("ref") = wrap(col_ref),
+                           Named("score") = wrap(col_score));
+}
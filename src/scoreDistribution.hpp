@@ -0,0 +1,86 @@
+#ifndef SCORE_DISTRIBUTION_HPP
+#define SCORE_DISTRIBUTION_HPP
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include "sparseSimilarity.hpp"
+
+// Namespace declarations
+using namespace std;
+
+// Distinct scores with their multiplicities, in increasing score order
+typedef vector<pair<double, uint64_t>> ScoreCounts;
+
+// Quantile of a score distribution, computed like R's default
+// quantile(x, p) (type 7) on the expanded vector; NaN when it is empty
+inline double score_quantile(const ScoreCounts& counts, double p) {
+  uint64_t total = 0;
+  for (const pair<double, uint64_t>& c : counts) {
+    total += c.second;
+  }
+  if (total == 0) {
+    return numeric_limits<double>::quiet_NaN();
+  }
+
+  // 1-based order statistic at rank r
+  auto value_at = [&](uint64_t r) {
+    uint64_t seen = 0;
+    for (const pair<double, uint64_t>& c : counts) {
+      seen += c.second;
+      if (seen >= r) {
+        return c.first;
+      }
+    }
+    return counts.back().first;
+  };
+
+  double index = 1.0 + static_cast<double>(total - 1) * p;
+  uint64_t lo = static_cast<uint64_t>(std::floor(index));
+  uint64_t hi = static_cast<uint64_t>(std::ceil(index));
+  double q = value_at(lo);
+  double x_hi = value_at(hi);
+  if (index > lo && x_hi != q) {
+    double h = index - lo;
+    q = (1 - h) * q + h * x_hi;
+  }
+  return q;
+}
+
+// Exact distribution of arbitrary pairwise scores, counted per distinct
+// value while a kernel fills its output. Meant for kernels whose per-pair
+// cost dwarfs a hash-table update (alignments); add() may be called
+// concurrently from OpenMP threads. NaN scores (two empty sequences) are
+// left out, as quantile(x, p, na.rm = TRUE) does: they would never match
+// themselves as keys and would break the ordering of counts().
+class ScoreTally {
+private:
+  vector<unordered_map<double, uint64_t>> tallies;
+
+public:
+  explicit ScoreTally(int n_threads = max_threads()) : tallies(max(n_threads, 1)) {}
+
+  // Count `weight` pairs scoring `score`
+  void add(double score, uint64_t weight = 1) {
+    if (std::isnan(score)) {
+      return;
+    }
+    tallies[current_thread()][score] += weight;
+  }
+
+  ScoreCounts counts() const {
+    unordered_map<double, uint64_t> merged;
+    for (const unordered_map<double, uint64_t>& tally : tallies) {
+      for (const pair<const double, uint64_t>& c : tally) {
+        merged[c.first] += c.second;
+      }
+    }
+    ScoreCounts out(merged.begin(), merged.end());
+    sort(out.begin(), out.end());
+    return out;
+  }
+};
+
+#endif // SCORE_DISTRIBUTION_HPP
@@ -0,0 +1,123 @@
+#ifndef SEQUENCE_READER_HPP
+#define SEQUENCE_READER_HPP
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mappedFile.hpp"
+
+using namespace std;
+
+// Streams sequences from a FASTA file (records start with '>' and their
+// sequence lines are joined) or from plain text with one sequence per line,
+// chosen by the first non-blank character. Files are memory-mapped and read
+// in place; "-" reads standard input. Only the current sequence is held in
+// memory, so callers can process inputs of any size batch by batch.
+class SequenceReader {
+private:
+  unique_ptr<MappedFile> file;
+  const char* pos;
+  const char* end;
+  istream* stream;
+  bool fasta;
+  bool in_record;  // a FASTA header was read whose sequence is still pending
+
+  // Next line without surrounding whitespace; false at the end of the input
+  bool next_line(string& line) {
+    if (stream) {
+      if (!getline(*stream, line)) {
+        return false;
+      }
+    } else {
+      if (pos >= end) {
+        return false;
+      }
+      const char* stop = static_cast<const char*>(memchr(pos, '\n', end - pos));
+      if (!stop) {
+        stop = end;
+      }
+      line.assign(pos, stop);
+      pos = stop < end ? stop + 1 : end;
+    }
+    size_t first = 0, last = line.size();
+    while (first < last && isspace(static_cast<unsigned char>(line[first]))) {
+      ++first;
+    }
+    while (last > first && isspace(static_cast<unsigned char>(line[last - 1]))) {
+      --last;
+    }
+    line = line.substr(first, last - first);
+    return true;
+  }
+
+public:
+  explicit SequenceReader(const string& path)
+    : pos(0), end(0), stream(0), fasta(false), in_record(false) {
+    int c = EOF;
+    if (path == "-") {
+      stream = &cin;
+      while ((c = stream->peek()) != EOF && isspace(c)) {
+        stream->get();
+      }
+    } else {
+      file.reset(new MappedFile(path, "sequence file"));
+      pos = file->data();
+      end = pos + file->size();
+      while (pos < end && isspace(static_cast<unsigned char>(*pos))) {
+        ++pos;
+      }
+      c = pos < end ? *pos : EOF;
+    }
+    fasta = c == '>';
+  }
+
+  bool is_fasta() const { return fasta; }
+
+  // Read the next sequence into `seq`; false once the input is exhausted
+  bool next(string& seq) {
+    seq.clear();
+    string line;
+    if (!fasta) {
+      while (next_line(line)) {
+        if (!line.empty()) {
+          seq.swap(line);
+          return true;
+        }
+      }
+      return false;
+    }
+    bool record = in_record;
+    while (next_line(line)) {
+      if (line.empty()) {
+        continue;
+      }
+      if (line[0] == '>') {
+        if (record) {
+          in_record = true;  // this header starts the next record
+          return true;
+        }
+        record = true;
+        continue;
+      }
+      seq += line;
+      record = true;
+    }
+    in_record = false;
+    return record;
+  }
+
+  // Replace `batch` with up to `size` next sequences; false if none were left
+  bool next_batch(vector<string>& batch, size_t size) {
+    batch.clear();
+    string seq;
+    while (batch.size() < size && next(seq)) {
+      batch.push_back(seq);
+    }
+    return !batch.empty();
+  }
+};
+
+#endif // SEQUENCE_READER_HPP
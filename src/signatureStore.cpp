@@ -0,0 +1,247 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "minHash.hpp"
+#include "packedSignatures.hpp"
+#include "signatureStore.hpp"
+#include "similarityResult.hpp"
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// Header fields of a store as an R list
+static List store_info(const string& path, const SignatureStoreHeader& header) {
+  return List::create(Named("path") = path,
+                      Named("n") = static_cast<double>(header.n),
+                      Named("k") = static_cast<int>(header.k),
+                      Named("n_hash") = static_cast<int>(header.n_hash),
+                      Named("method") = sketch_method_name(static_cast<SketchMethod>(header.method)),
+                      Named("bits") = static_cast<int>(header.bits),
+                      Named("seed") = static_cast<int>(header.seed),
+                      Named("alphabet") = string(header.alphabet));
+}
+
+// 0-based store rows of the 1-based `rows` argument
+static vector<size_t> store_rows(Rcpp::Nullable<Rcpp::IntegerVector> rows, size_t n_rows) {
+  IntegerVector selected(rows.get());
+  int n = static_cast<int>(n_rows);
+  vector<size_t> index(selected.length());
+  for (size_t r = 0; r < index.size(); ++r) {
+    if (selected[r] == NA_INTEGER || selected[r] < 1 || selected[r] > n) {
+      Rcpp::stop("'rows' must be indices between 1 and %d", n);
+    }
+    index[r] = selected[r] - 1;
+  }
+  return index;
+}
+
+//' @name createSignatureStore
+//' @title Build a Persistent MinHash Signature Store
+//'
+//' @description
+//' Sketches `sequences` with a fixed seed and writes the signatures to a
+//' binary file that [similarityStore()] memory-maps back without parsing.
+//' The file header records `k`, `n_hash`, `method`, `bits`, the seed and the
+//' residue alphabet, so [appendSignatureStore()] can later sketch new
+//' sequences compatibly and signatures are reproducible across runs.
+//'
+//' @param sequences A character vector of input sequences (may be empty)
+//' @param path File to create; an existing file is overwritten
+//' @param k The length of k-mers to use (default: 4)
+//' @param n_hash Number of hash functions to use (default: 100)
+//' @param method Sketch method, as in [similarityMH()] (default: "mix")
+//' @param bits Bits kept per signature slot, as in [similarityMH()]
+//'        (default: 32)
+//' @param seed Non-negative seed of the hash functions (default: 42)
+//' @return A list describing the store: `path`, `n` (number of signatures),
+//'         `k`, `n_hash`, `method`, `bits`, `seed` and `alphabet`
+//' @export
+// [[Rcpp::export]]
+List createSignatureStore(CharacterVector sequences, std::string path, int k = 4,
+                          int n_hash = 100, std::string method = "mix", int bits = 32,
+                          int seed = 42) {
+  if (k <= 0) {
+    Rcpp::stop("'k' must be a positive integer");
+  }
+  if (n_hash <= 0) {
+    Rcpp::stop("Number of hash functions must be positive");
+  }
+  if (!valid_signature_bits(bits)) {
+    Rcpp::stop("'bits' must be one of 1, 2, 4, 8, 16 or 32");
+  }
+  if (seed < 0) {
+    Rcpp::stop("'seed' must be a non-negative integer");
+  }
+
+  SignatureStoreHeader params = make_store_header(k, n_hash, parse_sketch_method(method), bits,
+                                                  static_cast<uint32_t>(seed));
+  SignatureStoreHeader header = create_signature_store(path, as<vector<string>>(sequences), params);
+  return store_info(path, header);
+}
+
+//' @name createSignatureStores
+//' @title Build Signature Stores for Several k in One Pass
+//'
+//' @description
+//' Writes one store per k-mer length for a parameter sweep, reading and
+//' encoding every sequence once: all lengths are rolled along the same pass
+//' over its residues. Store `p` is identical to
+//' `createSignatureStore(sequences, paths[p], k[p], n_hash, method, bits, seed)`,
+//' and since slot `s` of a `"mix"` or `"classic"` signature depends only on
+//' the seed and `s`, `similarityStore(paths[p], n_hash = n)` gives the
+//' similarities for any `n <= n_hash` from prefixes of the stored signatures.
+//' One sketch then serves every `(k, n_hash)` of the sweep.
+//'
+//' @param sequences A character vector of input sequences (may be empty)
+//' @param paths Files to create, one per entry of `k`; existing files are
+//'        overwritten
+//' @param k The k-mer lengths, one per store
+//' @param n_hash Number of hash functions: the largest `n_hash` of the sweep
+//'        (default: 100)
+//' @param method Sketch method, `"mix"` or `"classic"`; `"oph"` signatures
+//'        have no usable prefixes (default: "mix")
+//' @param bits Bits kept per signature slot, as in [similarityMH()]
+//'        (default: 32)
+//' @param seed Non-negative seed of the hash functions (default: 42)
+//' @return A list with the description of each store, as in
+//'         [createSignatureStore()]
+//' @export
+// [[Rcpp::export]]
+List createSignatureStores(CharacterVector sequences, CharacterVector paths, IntegerVector k,
+                           int n_hash = 100, std::string method = "mix", int bits = 32,
+                           int seed = 42) {
+  if (paths.length() != k.length()) {
+    Rcpp::stop("'paths' must have one entry per k-mer length");
+  }
+  for (R_xlen_t p = 0; p < k.length(); ++p) {
+    if (k[p] == NA_INTEGER || k[p] <= 0) {
+      Rcpp::stop("'k' must be positive integers");
+    }
+  }
+  if (n_hash <= 0) {
+    Rcpp::stop("Number of hash functions must be positive");
+  }
+  if (!valid_signature_bits(bits)) {
+    Rcpp::stop("'bits' must be one of 1, 2, 4, 8, 16 or 32");
+  }
+  if (seed < 0) {
+    Rcpp::stop("'seed' must be a non-negative integer");
+  }
+  SketchMethod sketch_method = parse_sketch_method(method);
+  if (sketch_method == SKETCH_OPH) {
+    Rcpp::stop("'method' must be \"mix\" or \"classic\" for stores sketched together");
+  }
+
+  vector<string> store_paths = as<vector<string>>(paths);
+  vector<SignatureStoreHeader> params;
+  for (R_xlen_t p = 0; p < k.length(); ++p) {
+    params.push_back(make_store_header(k[p], n_hash, sketch_method, bits,
+                                       static_cast<uint32_t>(seed)));
+  }
+  vector<SignatureStoreHeader> headers = create_signature_stores(store_paths,
+                                                                 as<vector<string>>(sequences),
+                                                                 params);
+  List out(headers.size());
+  for (size_t p = 0; p < headers.size(); ++p) {
+    out[p] = store_info(store_paths[p], headers[p]);
+  }
+  return out;
+}
+
+//' @name appendSignatureStore
+//' @title Add Sequences to a MinHash Signature Store
+//'
+//' @description
+//' Sketches only the new `sequences`, using the parameters and seed recorded
+//' in the store, and appends their signatures after the existing ones. Rows
+//' keep their order, so row `i` of the store is the `i`-th sequence ever
+//' added.
+//'
+//' @param sequences A character vector of sequences to add
+//' @param path A store created by [createSignatureStore()]
+//' @return The updated store description, as in [createSignatureStore()]
+//' @export
+// [[Rcpp::export]]
+List appendSignatureStore(CharacterVector sequences, std::string path) {
+  SignatureStoreHeader header = append_signature_store(path, as<vector<string>>(sequences));
+  return store_info(path, header);
+}
+
+//' @name signatureStoreInfo
+//' @title Describe a MinHash Signature Store
+//'
+//' @param path A store created by [createSignatureStore()]
+//' @return The store description, as in [createSignatureStore()]
+//' @export
+// [[Rcpp::export]]
+List signatureStoreInfo(std::string path) {
+  SignatureStore store(path);
+  return store_info(path, store.header());
+}
+
+//' @name similarityStore
+//' @title MinHash Similarities of a Signature Store
+//'
+//' @description
+//' Computes all pairwise MinHash similarities of the signatures in a store,
+//' reading them in place from a memory mapping instead of re-sketching the
+//' sequences. With `rows`, only the listed signatures are compared, so the
+//' similarities of any subset of a sketched collection cost no hashing.
+//'
+//' @param path A store created by [createSignatureStore()]
+//' @param rows Optional 1-based store rows to compare, in the order of the
+//'        result (default: NULL, every row)
+//' @param sparse If `TRUE`, return only the retained pairs as an edge list
+//'        instead of the dense matrix (default: FALSE)
+//' @param threshold Minimum similarity for a pair to be kept in sparse mode
+//'        (default: 0, i.e. every pair with non-zero similarity)
+//' @param top_k If positive, each sequence keeps only its `top_k` most similar
+//'        neighbours in sparse mode (default: 0, no limit)
+//' @param cut_quantile Exact quantile cut, as in [similarityMH()]
+//'        (default: NA, no cut)
+//' @param profile If `TRUE`, attach phase times and counters as in
+//'        [similarityMH()], with a `load` phase instead of `sketch`
+//'        (default: FALSE)
+//' @param n_hash If positive, compare only the first `n_hash` slots of each
+//'        signature, which gives exactly the similarities of a store
+//'        sketched with that `n_hash` and the same seed (not available for
+//'        method `"oph"`) (default: 0, every slot)
+//' @return A numeric matrix of pairwise similarities, or with `sparse = TRUE`
+//'         a `sparse_similarity` data frame with 1-based columns `i < j` and
+//'         `score`, and the number of sequences in `attr(, "n")`
+//' @export
+// [[Rcpp::export]]
+SEXP similarityStore(std::string path, Rcpp::Nullable<Rcpp::IntegerVector> rows = R_NilValue,
+                     bool sparse = false, double threshold = 0.0, int top_k = 0,
+                     double cut_quantile = NA_REAL, bool profile = false, int n_hash = 0) {
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  if (n_hash < 0) {
+    Rcpp::stop("'n_hash' must be a non-negative integer");
+  }
+  check_cut_quantile(cut_quantile);
+  KernelProfile kernel_profile(profile);
+  kernel_profile.begin("load");
+  SignatureStore store(path);
+  if (n_hash > 0 && n_hash != static_cast<int>(store.header().n_hash)) {
+    PackedSignatures prefix = store_prefix(store, n_hash);
+    if (rows.isNull()) {
+      return kernel_profile.attach(pairwise_signature_similarity(prefix, sparse, threshold, top_k,
+                                                                 cut_quantile, kernel_profile));
+    }
+    PackedSignatures subset = prefix.subset(store_rows(rows, prefix.size()));
+    return kernel_profile.attach(pairwise_signature_similarity(subset, sparse, threshold, top_k,
+                                                               cut_quantile, kernel_profile));
+  }
+  if (rows.isNull()) {
+    return kernel_profile.attach(pairwise_signature_similarity(store.signatures(), sparse,
+                                                               threshold, top_k, cut_quantile,
+                                                               kernel_profile));
+  }
+
+  PackedSignatures subset = store.signatures().subset(store_rows(rows, store.header().n));
+  return kernel_profile.attach(pairwise_signature_similarity(subset, sparse, threshold, top_k,
+                                                             cut_quantile, kernel_profile));
+}
@@ -0,0 +1,226 @@
+#ifndef SIGNATURE_STORE_HPP
+#define SIGNATURE_STORE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "alphabet.hpp"
+#include "minHash.hpp"
+#include "packedSignatures.hpp"
+#include "mappedFile.hpp"
+#include "coreError.hpp"
+
+using namespace std;
+
+// On-disk MinHash signature store.
+//
+// A 128-byte header followed by the packed signature rows exactly as
+// PackedSignatures lays them out in memory (row_words 64-bit words per row,
+// native byte order). Since the header is a multiple of 64 bytes and mappings
+// start on a page boundary, the rows of a mapped store are cache-aligned and
+// are used in place without parsing.
+//
+// The header records everything needed to sketch new sequences compatibly:
+// k, n_hash, sketch method, bits and the hash seed, plus the residue alphabet
+// of the rolling k-mer encoder. Appending writes the new rows first and only
+// then updates the row count, so an interrupted append leaves the store at
+// its previous, valid state.
+const char SIGNATURE_STORE_MAGIC[8] = {'D', 'Y', 'N', 'A', 'S', 'I', 'G', '\0'};
+const uint32_t SIGNATURE_STORE_VERSION = 1;
+const uint32_t SIGNATURE_STORE_BYTE_ORDER = 0x01020304;
+
+struct SignatureStoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t k;
+  uint32_t n_hash;
+  uint32_t bits;
+  uint32_t method;
+  uint64_t seed;
+  uint64_t n;          // number of rows
+  uint64_t row_words;  // 64-bit words per row
+  char alphabet[32];   // RESIDUE_SYMBOLS, zero padded
+  char reserved[40];
+};
+
+static_assert(sizeof(SignatureStoreHeader) == 128, "signature store header must be 128 bytes");
+
+inline SignatureStoreHeader make_store_header(int k, int n_hash, SketchMethod method, int bits,
+                                              uint32_t seed) {
+  SignatureStoreHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SIGNATURE_STORE_MAGIC, sizeof(header.magic));
+  header.version = SIGNATURE_STORE_VERSION;
+  header.byte_order = SIGNATURE_STORE_BYTE_ORDER;
+  header.k = k;
+  header.n_hash = n_hash;
+  header.bits = bits;
+  header.method = method;
+  header.seed = seed;
+  header.n = 0;
+  header.row_words = signature_row_words(n_hash, bits);
+  strncpy(header.alphabet, RESIDUE_SYMBOLS, sizeof(header.alphabet) - 1);
+  return header;
+}
+
+// Reject anything this build could not read or extend compatibly
+inline void check_store_header(const SignatureStoreHeader& header, const string& path) {
+  if (memcmp(header.magic, SIGNATURE_STORE_MAGIC, sizeof(header.magic)) != 0) {
+    core_stop("Not a signature store: %s", path);
+  }
+  if (header.version != SIGNATURE_STORE_VERSION) {
+    core_stop("Unsupported signature store version %d: %s", static_cast<int>(header.version), path);
+  }
+  if (header.byte_order != SIGNATURE_STORE_BYTE_ORDER) {
+    core_stop("Signature store was written with a different byte order: %s", path);
+  }
+  if (header.k == 0 || header.n_hash == 0 || !valid_signature_bits(header.bits) ||
+      header.method > SKETCH_CLASSIC ||
+      header.row_words != signature_row_words(header.n_hash, header.bits)) {
+    core_stop("Corrupt signature store header: %s", path);
+  }
+  if (strncmp(header.alphabet, RESIDUE_SYMBOLS, sizeof(header.alphabet)) != 0) {
+    core_stop("Signature store uses a different residue alphabet: %s", path);
+  }
+}
+
+// The signature engine a store was built with
+inline MinHasher store_hasher(const SignatureStoreHeader& header) {
+  return MinHasher(header.k, header.n_hash, static_cast<SketchMethod>(header.method),
+                   static_cast<unsigned int>(header.seed));
+}
+
+// A signature store mapped into memory; signatures() is a view of the
+// mapped rows and stays valid as long as the store object
+class SignatureStore {
+private:
+  MappedFile file;
+  SignatureStoreHeader head;
+
+public:
+  explicit SignatureStore(const string& path) : file(path, "signature store") {
+    if (file.size() < sizeof(SignatureStoreHeader)) {
+      core_stop("Not a signature store: %s", path);
+    }
+    memcpy(&head, file.data(), sizeof(head));
+    check_store_header(head, path);
+    if ((file.size() - sizeof(head)) / sizeof(uint64_t) / head.row_words < head.n) {
+      core_stop("Signature store is truncated: %s", path);
+    }
+  }
+
+  const SignatureStoreHeader& header() const { return head; }
+
+  PackedSignatures signatures() const {
+    const uint64_t* rows = reinterpret_cast<const uint64_t*>(file.data() + sizeof(head));
+    return PackedSignatures(head.n, head.n_hash, head.bits, rows);
+  }
+};
+
+// Write rows [0, n) of `signatures` at row offset `first` of an open store
+inline void write_store_rows(fstream& out, const SignatureStoreHeader& header, uint64_t first,
+                             const PackedSignatures& signatures) {
+  if (signatures.size() == 0) {
+    return;
+  }
+  streamoff row_bytes = static_cast<streamoff>(header.row_words * sizeof(uint64_t));
+  out.seekp(static_cast<streamoff>(sizeof(header)) + static_cast<streamoff>(first) * row_bytes);
+  out.write(reinterpret_cast<const char*>(signatures.row(0)),
+            static_cast<streamsize>(signatures.size()) * row_bytes);
+}
+
+// Create (or overwrite) a store holding `signatures`
+inline SignatureStoreHeader write_signature_store(const string& path,
+                                                  const SignatureStoreHeader& params,
+                                                  const PackedSignatures& signatures) {
+  SignatureStoreHeader header = params;
+  header.n = signatures.size();
+
+  fstream out(path.c_str(), ios::out | ios::binary | ios::trunc);
+  if (!out) {
+    core_stop("Cannot create signature store: %s", path);
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write_store_rows(out, header, 0, signatures);
+  out.flush();
+  if (!out) {
+    core_stop("Failed to write signature store: %s", path);
+  }
+  return header;
+}
+
+// Create (or overwrite) a store holding the signatures of `seqs`
+inline SignatureStoreHeader create_signature_store(const string& path, const vector<string>& seqs,
+                                                   const SignatureStoreHeader& params) {
+  return write_signature_store(path, params,
+                               compute_signatures(seqs, store_hasher(params), params.bits));
+}
+
+// Create one store per header of `params`, which may differ only in k,
+// sketching every sequence once for all of them
+inline vector<SignatureStoreHeader> create_signature_stores(const vector<string>& paths,
+                                                            const vector<string>& seqs,
+                                                            const vector<SignatureStoreHeader>& params) {
+  vector<MinHasher> hashers;
+  for (size_t p = 0; p < params.size(); ++p) {
+    hashers.push_back(store_hasher(params[p]));
+  }
+  int bits = params.empty() ? 32 : static_cast<int>(params[0].bits);
+  vector<PackedSignatures> signatures = compute_signatures_multi_k(seqs, hashers, bits);
+  vector<SignatureStoreHeader> headers;
+  for (size_t p = 0; p < params.size(); ++p) {
+    headers.push_back(write_signature_store(paths[p], params[p], signatures[p]));
+  }
+  return headers;
+}
+
+// The first `n_hash` slots of the signatures of a store, which equal the
+// signatures a store with that n_hash and the same seed would hold
+inline PackedSignatures store_prefix(const SignatureStore& store, int n_hash) {
+  const SignatureStoreHeader& header = store.header();
+  if (n_hash <= 0 || n_hash > static_cast<int>(header.n_hash)) {
+    core_stop("'n_hash' must be between 1 and the %d slots of the store",
+              static_cast<int>(header.n_hash));
+  }
+  if (header.method == SKETCH_OPH) {
+    core_stop("Signatures of method \"%s\" cannot be cut to fewer slots",
+              sketch_method_name(static_cast<SketchMethod>(header.method)));
+  }
+  return store.signatures().prefix(n_hash);
+}
+
+// Sketch `seqs` with the store's own parameters and add them after its
+// existing rows
+inline SignatureStoreHeader append_signature_store(const string& path, const vector<string>& seqs) {
+  fstream io(path.c_str(), ios::in | ios::out | ios::binary);
+  if (!io) {
+    core_stop("Cannot open signature store: %s", path);
+  }
+  SignatureStoreHeader header;
+  if (!io.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    core_stop("Not a signature store: %s", path);
+  }
+  check_store_header(header, path);
+
+  PackedSignatures signatures = compute_signatures(seqs, store_hasher(header), header.bits);
+  write_store_rows(io, header, header.n, signatures);
+  io.flush();
+  if (!io) {
+    core_stop("Failed to write signature store: %s", path);
+  }
+
+  // Commit the new rows by updating the count last
+  header.n += seqs.size();
+  io.seekp(0);
+  io.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  io.flush();
+  if (!io) {
+    core_stop("Failed to write signature store: %s", path);
+  }
+  return header;
+}
+
+#endif // SIGNATURE_STORE_HPP
@@ -0,0 +1,152 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "minHash.hpp"
+#include "lshIndex.hpp"
+#include "needlemanWunsch.hpp"
+#include "packedSignatures.hpp"
+#include "pairScheduler.hpp"
+#include "sparseSimilarity.hpp"
+#include "similarityResult.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+//' @name similarityHybrid
+//' @title MinHash-Filtered Needleman-Wunsch Similarity
+//'
+//' @description
+//' Two-stage similarity: an LSH banding index over the MinHash signatures
+//' (see [similarityLSH()]) proposes candidate pairs, and only the candidates
+//' whose MinHash similarity reaches `mh_cutoff` are aligned with
+//' Needleman-Wunsch. The result holds exact alignment similarities for those
+//' candidates; every other pair is treated as 0.
+//'
+//' @details
+//' The signatures of `n_hash` slots are cut into `floor(n_hash / rows)` bands. By
+//' default `rows` is the largest band width at which a pair whose MinHash
+//' similarity is exactly `mh_cutoff` still shares a band with probability
+//' 0.99, so that few pairs above the cutoff are lost while the candidates
+//' stay far fewer than all pairs. With `mh_cutoff = 0` there is nothing to
+//' filter and every pair is aligned.
+//'
+//' @param sequences A character vector of input sequences
+//' @param mh_cutoff Minimum MinHash similarity for a pair to be aligned
+//'        (default: 0.2)
+//' @param k The length of k-mers to use (default: 4)
+//' @param n_hash Number of hash functions to use (default: 100)
+//' @param method MinHash sketch method, see [similarityMH()] (default: "mix")
+//' @param matrixName A substitution matrix for scoring alignments, see
+//'        [similarityNW()] (default: "BLOSUM62")
+//' @param gapOpen Penalty for opening a gap in the alignment (default: 10)
+//' @param gapExt Penalty for extending an existing gap (default: 4)
+//' @param threshold Minimum alignment similarity for a pair to be kept
+//'        (default: 0, i.e. every candidate with non-zero similarity)
+//' @param top_k If positive, each sequence keeps only its `top_k` most similar
+//'        neighbours (default: 0, no limit)
+//' @param band Banded alignment width, see [similarityNW()] (default: -1, none)
+//' @param threads Number of threads (default: 0, all available cores)
+//' @param rows Signature values per LSH band, at most `n_hash`; 0 picks them
+//'        from `mh_cutoff`, see Details (default: 0)
+//' @param max_bucket Largest LSH bucket whose members are all paired, see
+//'        [similarityLSH()] (default: 1000)
+//' @param seed Seed of the hash functions, so that the candidates are
+//'        reproducible (default: 42)
+//' @return A `sparse_similarity` data frame with 1-based columns `i < j` and
+//'         the Needleman-Wunsch similarity in `score`, the number of
+//'         sequences in `attr(, "n")` and the number of capped LSH buckets
+//'         in `attr(, "capped_buckets")`
+//' @export
+// [[Rcpp::export]]
+DataFrame similarityHybrid(CharacterVector sequences, double mh_cutoff = 0.2,
+                           int k = 4, int n_hash = 100, std::string method = "mix",
+                           std::string matrixName = "BLOSUM62",
+                           int gapOpen = 10, int gapExt = 4,
+                           double threshold = 0.0, int top_k = 0,
+                           int band = -1, int threads = 0,
+                           int rows = 0, int max_bucket = 1000, int seed = 42) {
+  if (sequences.length() == 0) {
+    Rcpp::stop("Input sequences vector cannot be empty");
+  }
+  if (k <= 0) {
+    Rcpp::stop("'k' must be a positive integer");
+  }
+  if (n_hash <= 0) {
+    Rcpp::stop("Number of hash functions must be positive");
+  }
+  if (mh_cutoff < 0.0 || mh_cutoff > 1.0) {
+    Rcpp::stop("'mh_cutoff' must be between 0 and 1");
+  }
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  if (rows < 0 || rows > n_hash) {
+    Rcpp::stop("'rows' must be between 0 and 'n_hash'");
+  }
+  if (max_bucket < 0) {
+    Rcpp::stop("'max_bucket' must be a non-negative integer");
+  }
+  if (seed < 0) {
+    Rcpp::stop("'seed' must be a non-negative integer");
+  }
+  if (band < -1) {
+    Rcpp::stop("'band' must be -1 (no band), 0 (automatic) or a positive width");
+  }
+  int n_threads = resolve_threads(threads);
+
+  size_t n = sequences.length();
+  vector<string> seqs = as<vector<string>>(sequences);
+  const int (*substitutionMatrix)[24] = getSubstitutionMatrix(matrixName);
+  MinHasher hasher(k, n_hash, parse_sketch_method(method), static_cast<unsigned int>(seed));
+
+  // Convert every sequence once, outside the parallel regions
+  vector<vector<uint8_t>> encoded = encode_sequences(seqs);
+  vector<size_t> lengths(n);
+  for (size_t i = 0; i < n; ++i) {
+    lengths[i] = encoded[i].size();
+  }
+
+  // Stage 1: LSH candidates whose MinHash similarity reaches the cutoff
+  PackedSignatures signatures = compute_signatures(seqs, hasher, 32, n_threads);
+  vector<vector<pair<int, int>>> found(n_threads);
+  size_t capped = 0;
+  if (mh_cutoff > 0.0) {
+    if (rows == 0) {
+      rows = lsh_rows_for_recall(n_hash, mh_cutoff, 0.99);
+    }
+    capped = for_each_lsh_candidate(signatures, n_hash / rows, rows, max_bucket, n_threads,
+                                    [&](int i, int j) {
+      if (signatures.similarity(i, j) >= mh_cutoff) {
+        found[current_thread()].push_back(make_pair(i, j));
+      }
+    });
+  } else {
+    for_each_pair_tiled(n, signature_tile_rows(signatures), [&](size_t i, size_t j) {
+      found[current_thread()].push_back(make_pair(static_cast<int>(i), static_cast<int>(j)));
+    }, n_threads);
+  }
+
+  vector<pair<int, int>> candidates;
+  for (const vector<pair<int, int>>& buffer : found) {
+    candidates.insert(candidates.end(), buffer.begin(), buffer.end());
+  }
+
+  // Stage 2: align the candidates, abandoning those that cannot reach threshold
+  SparseSimilarity edges(n, threshold, top_k, n_threads);
+  vector<NWWorkspace> workspaces(n_threads);
+  for_each_listed_pair(candidates, lengths, n_threads, [&](int i, int j, int thread) {
+    edges.add(i, j, calculate_similarity(encoded[i], encoded[j], substitutionMatrix,
+                                         gapOpen, gapExt, workspaces[thread], band, threshold));
+  });
+
+  DataFrame result = similarity_data_frame(edges);
+  result.attr("capped_buckets") = static_cast<double>(capped);
+  return result;
+}
@@ -0,0 +1,399 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "jobControl.hpp"
+#include "needlemanWunsch.hpp"
+#include "minHash.hpp"
+#include "packedSignatures.hpp"
+#include "pairScheduler.hpp"
+#include "similarityResult.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// A similarity kernel running in the background. The workers fill native
+// buffers only; the R result is built from them on the main thread. Dense
+// jobs flag every computed entry, so that the pairs a cancelled job never
+// reached become NA while a NaN similarity (two empty sequences) stays NaN.
+struct SimilarityJob {
+  size_t n;
+  bool sparse;
+  DenseLayout layout;
+  vector<double> pairs;                // dense: pairs i < j in dist order
+  vector<uint8_t> pairs_done;          //   and whether each was computed
+  vector<double> diagonal;             // dense and full: self-similarities
+  vector<uint8_t> diagonal_done;
+  unique_ptr<SparseSimilarity> edges;  // sparse: the kept pairs
+  unique_ptr<BackgroundJob> task;      // last, so the worker is joined before the buffers go
+
+  SimilarityJob(size_t n, bool sparse, double threshold, int top_k, bool packed, bool dimnames,
+                int n_threads)
+    : n(n), sparse(sparse) {
+    layout = DEFAULT_LAYOUT;
+    layout.packed = packed;
+    layout.dimnames = dimnames;
+    if (sparse) {
+      edges.reset(new SparseSimilarity(n, threshold, top_k, n_threads));
+    } else {
+      pairs.assign(n * (n > 0 ? n - 1 : 0) / 2, 0.0);
+      pairs_done.assign(pairs.size(), 0);
+      diagonal.assign(packed ? 0 : n, 0.0);
+      diagonal_done.assign(diagonal.size(), 0);
+    }
+  }
+
+  // Pairs the job computes, self-similarities included
+  uint64_t work() const {
+    return static_cast<uint64_t>(n) * (n > 0 ? n - 1 : 0) / 2 + diagonal.size();
+  }
+
+  // Similarity of the pair i < j; may be called concurrently for distinct pairs
+  void set(size_t i, size_t j, double similarity) {
+    if (sparse) {
+      edges->add(static_cast<int>(i), static_cast<int>(j), similarity);
+    } else {
+      size_t e = i * n - i * (i + 1) / 2 + (j - i - 1);
+      pairs[e] = similarity;
+      pairs_done[e] = 1;
+    }
+  }
+
+  // Self-similarity of sequence i in a full dense result
+  void set_diagonal(size_t i, double similarity) {
+    diagonal[i] = similarity;
+    diagonal_done[i] = 1;
+  }
+};
+
+// The job behind an R handle returned by similarityNWJob() or similarityMHJob()
+static SimilarityJob& job_handle(SEXP job) {
+  if (!Rf_inherits(job, "similarity_job")) {
+    Rcpp::stop("'job' must be a similarity job");
+  }
+  XPtr<SimilarityJob> ptr(job);
+  if (!ptr.get()) {
+    Rcpp::stop("'job' no longer exists (handles do not survive saving or a new session)");
+  }
+  return *ptr;
+}
+
+static SEXP job_object(SimilarityJob* job) {
+  XPtr<SimilarityJob> ptr(job, true);
+  ptr.attr("class") = "similarity_job";
+  return ptr;
+}
+
+static const char* job_state(const BackgroundJob& task) {
+  const JobControl& control = task.control();
+  if (!task.finished()) {
+    return "running";
+  }
+  if (control.has_failed()) {
+    return "failed";
+  }
+  return control.pairs_done() < control.pairs_total() ? "cancelled" : "done";
+}
+
+//' @name similarityNWJob
+//' @title Needleman-Wunsch Similarities as a Background Job
+//'
+//' @description
+//' Starts the alignments of [similarityNW()] on worker threads and returns
+//' at once with a handle, so the R session stays usable during long runs.
+//' [jobStatus()] reports the pairs completed, the throughput and the
+//' estimated time left, [jobCancel()] stops the workers after their current
+//' block of pairs, and [jobResult()] waits for the job (interruptible) and
+//' returns its result, partial if it was cancelled. Errors of the workers
+//' are collected and raised by [jobResult()].
+//'
+//' The arguments mean what they mean for [similarityNW()]; `dedup`,
+//' `cut_quantile`, `profile`, `type` and tiled mode are not available.
+//'
+//' @param sequences A character vector of input sequences
+//' @param matrixName Substitution matrix (default: "BLOSUM62")
+//' @param gapOpen Gap opening penalty (default: 10)
+//' @param gapExt Gap extension penalty (default: 4)
+//' @param sparse If `TRUE`, the result is a `sparse_similarity` edge list
+//'        (default: FALSE)
+//' @param threshold Minimum similarity of a kept pair in sparse mode
+//'        (default: 0)
+//' @param top_k If positive, the number of neighbours each sequence keeps in
+//'        sparse mode (default: 0, no limit)
+//' @param threads Number of worker threads (default: 0, all available cores)
+//' @param engine Alignment backend, `"simd"` or `"scalar"` (default: "simd")
+//' @param band Band of the alignments (default: -1, no band)
+//' @param cutoff Similarity cutoff (default: 0)
+//' @param packed If `TRUE`, a dense result holds only the pairs `i < j` in
+//'        the order of a `dist` object (default: FALSE)
+//' @param dimnames If `FALSE`, a full dense result has no row and column
+//'        names (default: TRUE)
+//' @return A `similarity_job` handle
+//' @export
+// [[Rcpp::export]]
+SEXP similarityNWJob(CharacterVector sequences, std::string matrixName = "BLOSUM62",
+                     int gapOpen = 10, int gapExt = 4,
+                     bool sparse = false, double threshold = 0.0, int top_k = 0,
+                     int threads = 0, std::string engine = "simd",
+                     int band = -1, double cutoff = 0.0,
+                     bool packed = false, bool dimnames = true) {
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  if (engine != "simd" && engine != "scalar") {
+    Rcpp::stop("Invalid engine: %s (expected \"simd\" or \"scalar\")", engine);
+  }
+  if (band < -1) {
+    Rcpp::stop("'band' must be -1 (no band), 0 (automatic) or a positive width");
+  }
+  if (cutoff < 0.0 || cutoff > 1.0) {
+    Rcpp::stop("'cutoff' must be between 0 and 1");
+  }
+  int n_threads = resolve_threads(threads);
+  const int (*substitutionMatrix)[24] = getSubstitutionMatrix(matrixName);
+
+  // Invalid residues are reported here, before any worker starts
+  shared_ptr<vector<vector<uint8_t>>> encoded(
+    new vector<vector<uint8_t>>(encode_sequences(as<vector<string>>(sequences))));
+  bool use_simd = engine == "simd" && nw_simd_available(substitutionMatrix, band);
+  if (sparse) {
+    cutoff = std::max(cutoff, threshold);
+  }
+
+  SimilarityJob* job = new SimilarityJob(encoded->size(), sparse, threshold, top_k, packed,
+                                         dimnames, n_threads);
+  job->task.reset(new BackgroundJob(job->work(), [=](JobControl& control) {
+    vector<NWWorkspace> workspaces(n_threads);
+    for_each_alignment(*encoded, substitutionMatrix, gapOpen, gapExt, band, cutoff, use_simd,
+                       n_threads, workspaces, [&](size_t i, size_t j, double similarity) {
+      job->set(i, j, similarity);
+    }, &control);
+
+    // Self-alignments on the diagonal of a full dense result
+    long n_diagonal = static_cast<long>(job->diagonal.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+    for (long i = 0; i < n_diagonal; ++i) {
+      control.guard([&]() {
+        job->set_diagonal(i, calculate_similarity((*encoded)[i], (*encoded)[i], substitutionMatrix,
+                                                  gapOpen, gapExt, workspaces[current_thread()],
+                                                  band, cutoff));
+        control.advance(1);
+      });
+    }
+  }));
+  return job_object(job);
+}
+
+//' @name similarityMHJob
+//' @title MinHash Similarities as a Background Job
+//'
+//' @description
+//' Sketches and compares the sequences as [similarityMH()] does, on worker
+//' threads, and returns at once with a handle for [jobStatus()],
+//' [jobCancel()] and [jobResult()] (see [similarityNWJob()]). The hash
+//' functions are drawn from `seed`, so jobs are reproducible; `dedup`,
+//' `cut_quantile`, `profile`, `type` and tiled mode are not available.
+//'
+//' @param sequences A character vector of input sequences
+//' @param k The length of k-mers to use (default: 4)
+//' @param n_hash Number of hash functions to use (default: 50)
+//' @param method Signature engine, as in [similarityMH()] (default: "mix")
+//' @param bits Bits kept per signature slot, as in [similarityMH()]
+//'        (default: 32)
+//' @param sparse If `TRUE`, the result is a `sparse_similarity` edge list
+//'        (default: FALSE)
+//' @param threshold Minimum similarity of a kept pair in sparse mode
+//'        (default: 0)
+//' @param top_k If positive, the number of neighbours each sequence keeps in
+//'        sparse mode (default: 0, no limit)
+//' @param threads Number of worker threads (default: 0, all available cores)
+//' @param seed Seed of the hash functions (default: 42)
+//' @param packed If `TRUE`, a dense result holds only the pairs `i < j` in
+//'        the order of a `dist` object (default: FALSE)
+//' @param dimnames If `FALSE`, a full dense result has no row and column
+//'        names (default: TRUE)
+//' @return A `similarity_job` handle
+//' @export
+// [[Rcpp::export]]
+SEXP similarityMHJob(CharacterVector sequences, int k = 4, int n_hash = 50,
+                     std::string method = "mix", int bits = 32,
+                     bool sparse = false, double threshold = 0.0, int top_k = 0,
+                     int threads = 0, int seed = 42,
+                     bool packed = false, bool dimnames = true) {
+  if (sequences.length() == 0) {
+    Rcpp::stop("Input sequences vector cannot be empty");
+  }
+  if (k <= 0) {
+    Rcpp::stop("'k' must be a positive integer");
+  }
+  if (n_hash <= 0) {
+    Rcpp::stop("Number of hash functions must be positive");
+  }
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  if (!valid_signature_bits(bits)) {
+    Rcpp::stop("'bits' must be one of 1, 2, 4, 8, 16 or 32");
+  }
+  int n_threads = resolve_threads(threads);
+  shared_ptr<MinHasher> hasher(new MinHasher(k, n_hash, parse_sketch_method(method),
+                                             static_cast<unsigned int>(seed)));
+  shared_ptr<vector<string>> seqs(new vector<string>(as<vector<string>>(sequences)));
+
+  SimilarityJob* job = new SimilarityJob(seqs->size(), sparse, threshold, top_k, packed,
+                                         dimnames, n_threads);
+  // Sketching counts one unit per sequence on top of the pairs
+  job->task.reset(new BackgroundJob(seqs->size() + job->work(), [=](JobControl& control) {
+    PackedSignatures signatures = compute_signatures(*seqs, *hasher, bits, n_threads, &control);
+    if (control.stopped()) {
+      return;
+    }
+
+    // Signatures cost the same to compare, so tiles of equal-length rows
+    vector<size_t> lengths(seqs->size(), 1);
+    for_each_pair_balanced(lengths, n_threads, [&](size_t i, size_t j, int) {
+      job->set(i, j, signatures.similarity_of(signatures.matches(i, j)));
+    }, false, &control);
+    control.guard([&]() {
+      for (size_t i = 0; i < job->diagonal.size(); ++i) {
+        job->set_diagonal(i, 1.0);
+      }
+      control.advance(job->diagonal.size());
+    });
+  }));
+  return job_object(job);
+}
+
+//' @name jobStatus
+//' @title Progress of a Background Similarity Job
+//'
+//' @description
+//' Reports how far a job of [similarityNWJob()] or [similarityMHJob()] has
+//' come, without waiting for it.
+//'
+//' @param job A `similarity_job` handle
+//' @return A list containing:
+//'   \item{state}{`"running"`, `"done"`, `"cancelled"` or `"failed"`}
+//'   \item{pairs_done}{Pairs computed so far, self-similarities included;
+//'         a MinHash job also counts each sequence sketched as one}
+//'   \item{pairs_total}{Pairs of the whole job, counted the same way}
+//'   \item{elapsed}{Seconds since the job started, up to its end}
+//'   \item{pairs_per_sec}{Average throughput}
+//'   \item{eta}{Estimated seconds left while running, else 0; `NA` before
+//'         the first block of pairs is done}
+//' @export
+// [[Rcpp::export]]
+List jobStatus(SEXP job) {
+  const BackgroundJob& task = *job_handle(job).task;
+  const JobControl& control = task.control();
+  bool running = !task.finished();
+  const char* state = job_state(task);
+  double done = static_cast<double>(control.pairs_done());
+  double total = static_cast<double>(control.pairs_total());
+  double elapsed = control.elapsed();
+  double rate = elapsed > 0.0 ? done / elapsed : 0.0;
+  double eta = 0.0;
+  if (running) {
+    eta = rate > 0.0 ? (total - done) / rate : NA_REAL;
+  }
+  return List::create(Named("state") = state,
+                      Named("pairs_done") = done,
+                      Named("pairs_total") = total,
+                      Named("elapsed") = elapsed,
+                      Named("pairs_per_sec") = rate,
+                      Named("eta") = eta);
+}
+
+//' @name jobCancel
+//' @title Cancel a Background Similarity Job
+//'
+//' @description
+//' Asks the workers of a job to stop. They finish the block of pairs at
+//' hand, so the job ends shortly after; [jobResult()] then returns the
+//' pairs computed so far.
+//'
+//' @param job A `similarity_job` handle
+//' @return `TRUE` if the job was still running
+//' @export
+// [[Rcpp::export]]
+bool jobCancel(SEXP job) {
+  BackgroundJob& task = *job_handle(job).task;
+  bool running = !task.finished();
+  task.control().cancel();
+  return running;
+}
+
+//' @name jobResult
+//' @title Result of a Background Similarity Job
+//'
+//' @description
+//' Waits for a job of [similarityNWJob()] or [similarityMHJob()] and returns
+//' its result in the shape [similarityNW()] and [similarityMH()] give it.
+//' Waiting can be interrupted; that cancels the job, whose partial result
+//' can still be fetched. An error of any worker is raised here.
+//'
+//' @param job A `similarity_job` handle
+//' @param wait If `FALSE`, fail instead of waiting when the job is still
+//'        running (default: TRUE)
+//' @return The similarity matrix, packed vector or `sparse_similarity` edge
+//'         list, with `attr(, "complete")` `FALSE` for a cancelled job, whose
+//'         pairs not computed are `NA` in dense results (computed ones may
+//'         be `NaN`, for two empty sequences) and missing from sparse ones
+//' @export
+// [[Rcpp::export]]
+SEXP jobResult(SEXP job, bool wait = true) {
+  SimilarityJob& state = job_handle(job);
+  BackgroundJob& task = *state.task;
+  if (!wait && !task.finished()) {
+    Rcpp::stop("job is still running; wait for it or cancel it with jobCancel()");
+  }
+  while (!task.wait_for(0.1)) {
+    try {
+      Rcpp::checkUserInterrupt();
+    } catch (...) {
+      task.control().cancel();
+      task.wait();
+      throw;
+    }
+  }
+  task.wait();
+  try {
+    task.control().rethrow();
+  } catch (const std::exception& e) {
+    Rcpp::stop("similarity job failed: %s", e.what());
+  }
+
+  bool complete = task.control().pairs_done() == task.control().pairs_total();
+  RObject out;
+  if (state.sparse) {
+    out = similarity_data_frame(*state.edges);
+  } else {
+    size_t n = state.n;
+    DenseSimilarity result(n, state.layout);
+    long n_rows = static_cast<long>(n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (long i = 0; i < n_rows; ++i) {
+      size_t row = i * n - i * (i + 1) / 2;
+      for (size_t j = i + 1; j < n; ++j) {
+        size_t e = row + (j - i - 1);
+        result.set(i, j, state.pairs_done[e] ? state.pairs[e] : NA_REAL);
+      }
+    }
+    for (size_t i = 0; i < state.diagonal.size(); ++i) {
+      result.set_diagonal(i, state.diagonal_done[i] ? state.diagonal[i] : NA_REAL);
+    }
+    out = result.result();
+  }
+  out.attr("complete") = complete;
+  return out;
+}
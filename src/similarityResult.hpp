@@ -0,0 +1,501 @@
+#ifndef SIMILARITY_RESULT_HPP
+#define SIMILARITY_RESULT_HPP
+
+#include <Rcpp.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "packedSignatures.hpp"
+#include "sparseSimilarity.hpp"
+#include "scoreDistribution.hpp"
+#include "kernelProfile.hpp"
+#include "duplicateIndex.hpp"
+#include "tileStore.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+// R side of the similarity kernels: everything here builds R objects from
+// the results of the Rcpp-independent core headers.
+
+// Convert kept pairs to the R representation: a data.frame with 1-based
+// columns i, j and score, class "sparse_similarity" and the sequence count in
+// attr "n". Edges scoring below `cut` are left out.
+inline DataFrame similarity_data_frame(const SparseSimilarity& edges, double cut = 0.0) {
+  vector<SimilarityEdge> kept = edges.edges();
+  kept.erase(remove_if(kept.begin(), kept.end(),
+                       [cut](const SimilarityEdge& e) { return e.score < cut; }),
+             kept.end());
+  IntegerVector col_i(kept.size());
+  IntegerVector col_j(kept.size());
+  NumericVector col_score(kept.size());
+  for (size_t e = 0; e < kept.size(); ++e) {
+    col_i[e] = kept[e].i + 1;
+    col_j[e] = kept[e].j + 1;
+    col_score[e] = kept[e].score;
+  }
+  DataFrame out = DataFrame::create(Named("i") = col_i,
+                                    Named("j") = col_j,
+                                    Named("score") = col_score);
+  out.attr("class") = CharacterVector::create("sparse_similarity", "data.frame");
+  out.attr("n") = static_cast<int>(edges.nodes());
+  return out;
+}
+
+// Element type of a dense result, from the kernels' `type` argument
+enum ResultType { RESULT_DOUBLE, RESULT_INTEGER, RESULT_RAW };
+
+// Shape of a dense result
+struct DenseLayout {
+  ResultType type;
+  bool packed;    // only the pairs i < j, in the order of a dist object
+  bool dimnames;  // "1", "2", ... row and column names of a full matrix
+};
+
+const DenseLayout DEFAULT_LAYOUT = {RESULT_DOUBLE, false, true};
+
+inline DenseLayout parse_dense_layout(const string& type, bool packed, bool dimnames) {
+  DenseLayout layout = {RESULT_DOUBLE, packed, dimnames};
+  if (type == "integer") {
+    layout.type = RESULT_INTEGER;
+  } else if (type == "raw") {
+    layout.type = RESULT_RAW;
+  } else if (type != "double") {
+    Rcpp::stop("Invalid type: %s (expected \"double\", \"integer\" or \"raw\")", type);
+  }
+  return layout;
+}
+
+// Alignment similarity 1 in integer results, the resolution of tile stores
+const double NW_RESULT_SCALE = TILE_ALIGNMENT_SCALE;
+
+// Value standing for similarity 1 in an integer or raw result, given the
+// natural scale of a kernel's scores (at most 255 for raw bytes)
+inline double result_scale(const DenseLayout& layout, double scale) {
+  return layout.type == RESULT_RAW ? min(scale, 255.0) : scale;
+}
+
+// A dense similarity result filled in place, in its final R type: doubles,
+// or integers or raw bytes holding round(similarity * scale), so no
+// full-size copy is ever made. An undefined (NaN or NA) similarity is stored
+// as NA in integer results and as 0 in raw ones, which have no NA. Either a full n x n matrix or, packed, the
+// n * (n - 1) / 2 pairs i < j in the order of a dist object. set() may be
+// called concurrently for distinct pairs.
+class DenseSimilarity {
+private:
+  size_t n;
+  DenseLayout layout;
+  double scale;
+  size_t length;
+  RObject object;
+  double* doubles;
+  int* integers;
+  Rbyte* bytes;
+
+  size_t index(size_t i, size_t j) const {
+    return layout.packed ? i * n - i * (i + 1) / 2 + (j - i - 1) : i + j * n;
+  }
+
+  void store(size_t e, double similarity) {
+    switch (layout.type) {
+    case RESULT_DOUBLE:
+      doubles[e] = similarity;
+      break;
+    case RESULT_INTEGER:
+      integers[e] = std::isnan(similarity) ? NA_INTEGER
+        : static_cast<int>(std::lround(similarity * scale));
+      break;
+    case RESULT_RAW:
+      bytes[e] = std::isnan(similarity) ? 0
+        : static_cast<Rbyte>(std::lround(similarity * scale));
+      break;
+    }
+  }
+
+public:
+  DenseSimilarity(size_t n, const DenseLayout& layout, double scale = 1.0)
+    : n(n), layout(layout), scale(scale), doubles(nullptr), integers(nullptr), bytes(nullptr) {
+    length = layout.packed ? n * (n > 0 ? n - 1 : 0) / 2 : n * n;
+    switch (layout.type) {
+    case RESULT_DOUBLE:
+      if (layout.packed) {
+        NumericVector x(length);
+        doubles = x.begin();
+        object = x;
+      } else {
+        NumericMatrix x(n, n);
+        doubles = x.begin();
+        object = x;
+      }
+      break;
+    case RESULT_INTEGER:
+      if (layout.packed) {
+        IntegerVector x(length);
+        integers = x.begin();
+        object = x;
+      } else {
+        IntegerMatrix x(n, n);
+        integers = x.begin();
+        object = x;
+      }
+      break;
+    case RESULT_RAW:
+      if (layout.packed) {
+        RawVector x(length);
+        bytes = x.begin();
+        object = x;
+      } else {
+        RawMatrix x(n, n);
+        bytes = x.begin();
+        object = x;
+      }
+      break;
+    }
+  }
+
+  // Similarity of the pair i != j
+  void set(size_t i, size_t j, double similarity) {
+    if (i > j) {
+      swap(i, j);
+    }
+    store(index(i, j), similarity);
+    if (!layout.packed) {
+      store(index(j, i), similarity);
+    }
+  }
+
+  // Similarity of sequence i with itself; packed results have no diagonal
+  void set_diagonal(size_t i, double similarity) {
+    if (!layout.packed) {
+      store(i + i * n, similarity);
+    }
+  }
+
+  // Set every entry below `cut` to 0; integer and raw entries are compared
+  // with the cut rounded the same way, and NA entries are kept
+  void cut(double cut) {
+    long size = static_cast<long>(length);
+    double stored_cut = layout.type == RESULT_DOUBLE ? cut : std::lround(cut * scale);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (long e = 0; e < size; ++e) {
+      double value = doubles ? doubles[e]
+        : integers ? (integers[e] == NA_INTEGER ? NA_REAL : integers[e]) : bytes[e];
+      if (value < stored_cut) {
+        store(e, 0.0);
+      }
+    }
+  }
+
+  double size_bytes() const {
+    size_t element = layout.type == RESULT_DOUBLE ? sizeof(double)
+      : layout.type == RESULT_INTEGER ? sizeof(int) : 1;
+    return static_cast<double>(length) * element;
+  }
+
+  // The R object: packed results carry the number of sequences in attr
+  // "n", integer and raw ones the value of similarity 1 in attr "scale"
+  RObject result() {
+    if (layout.type != RESULT_DOUBLE) {
+      object.attr("scale") = scale;
+    }
+    if (layout.packed) {
+      object.attr("n") = static_cast<int>(n);
+    } else if (layout.dimnames) {
+      CharacterVector labels(n);
+      for (size_t i = 0; i < n; ++i) {
+        labels[i] = to_string(i + 1);
+      }
+      object.attr("dimnames") = List::create(labels, labels);
+    }
+    return object;
+  }
+};
+
+inline void check_cut_quantile(double cut_quantile) {
+  if (!ISNAN(cut_quantile) && (cut_quantile < 0.0 || cut_quantile > 1.0)) {
+    Rcpp::stop("'cut_quantile' must be NA or between 0 and 1");
+  }
+}
+
+// A quantile cut as stored in attr(, "threshold"): NA when there were no pairs
+inline double threshold_value(double q) {
+  return ISNAN(q) ? NA_REAL : q;
+}
+
+// How the kernels treat identical sequences, from their `dedup` argument
+enum DedupMode { DEDUP_NONE, DEDUP_EXPAND, DEDUP_COLLAPSE };
+
+inline DedupMode parse_dedup(const string& dedup) {
+  if (dedup == "none") {
+    return DEDUP_NONE;
+  }
+  if (dedup == "expand") {
+    return DEDUP_EXPAND;
+  }
+  if (dedup == "collapse") {
+    return DEDUP_COLLAPSE;
+  }
+  Rcpp::stop("Invalid dedup: %s (expected \"none\", \"expand\" or \"collapse\")", dedup);
+}
+
+// Collapse the identical entries of `seqs` for `mode`, recording the groups
+// in `duplicates`; the sequences to compare are returned
+inline vector<string> dedup_sequences(const vector<string>& seqs, DedupMode mode,
+                                      DuplicateIndex& duplicates, KernelProfile& profile) {
+  if (mode == DEDUP_NONE) {
+    return seqs;
+  }
+  profile.begin("dedup");
+  duplicates = collapse_duplicates(seqs);
+  profile.count("duplicates_collapsed", static_cast<double>(seqs.size() - duplicates.distinct()));
+  return distinct_sequences(seqs, duplicates);
+}
+
+// Cut recorded in attr(, "threshold") of a result, or 0 when there is none
+inline double result_cut(const RObject& result) {
+  if (!result.hasAttribute("threshold")) {
+    return 0.0;
+  }
+  double q = as<double>(result.attr("threshold"));
+  return ISNAN(q) ? 0.0 : q;
+}
+
+// Expand a full double matrix over the distinct sequences to all sequences,
+// in `layout`: the copies of u and v score like u and v, and two copies of u
+// like u with itself
+inline RObject expand_matrix(NumericMatrix distinct, const DuplicateIndex& duplicates,
+                             const DenseLayout& layout, double scale) {
+  size_t n = duplicates.size(), d = duplicates.distinct();
+  DenseSimilarity out(n, layout, scale);
+  const double* in = distinct.begin();
+  const vector<int>& group = duplicates.group;
+  long n_rows = static_cast<long>(n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (long i = 0; i < n_rows; ++i) {
+    const double* column = in + group[i] * d;
+    out.set_diagonal(i, column[group[i]]);
+    for (size_t j = i + 1; j < n; ++j) {
+      out.set(i, j, column[group[j]]);
+    }
+  }
+  return out.result();
+}
+
+// Expand a sparse_similarity result over the distinct sequences to all
+// sequences, adding the pairs of copies of u with score self_scores[u], and
+// keep the pairs that pass `threshold`, `top_k` and the result's cut as if
+// every sequence had been compared
+inline DataFrame expand_edges(const DataFrame& distinct, const DuplicateIndex& duplicates,
+                              const vector<double>& self_scores, double threshold, int top_k,
+                              double cut) {
+  vector<int> col_i = as<vector<int>>(distinct["i"]);
+  vector<int> col_j = as<vector<int>>(distinct["j"]);
+  vector<double> col_score = as<vector<double>>(distinct["score"]);
+  vector<vector<int>> members = duplicates.members();
+  SparseSimilarity edges(duplicates.size(), max(threshold, cut), top_k);
+  long n_edges = static_cast<long>(col_i.size());
+  long n_distinct = static_cast<long>(members.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64) nowait
+#endif
+    for (long e = 0; e < n_edges; ++e) {
+      for (int a : members[col_i[e] - 1]) {
+        for (int b : members[col_j[e] - 1]) {
+          edges.add(a, b, col_score[e]);
+        }
+      }
+    }
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+    for (long u = 0; u < n_distinct; ++u) {
+      const vector<int>& copies = members[u];
+      for (size_t a = 0; a < copies.size(); ++a) {
+        for (size_t b = a + 1; b < copies.size(); ++b) {
+          edges.add(copies[a], copies[b], self_scores[u]);
+        }
+      }
+    }
+  }
+  return similarity_data_frame(edges);
+}
+
+// Map a result computed on the distinct sequences back for `mode`: with
+// DEDUP_EXPAND to all sequences (see expand_matrix(), which also applies the
+// final `layout`, and expand_edges()), with DEDUP_COLLAPSE kept as is, with
+// the number of copies of each row in attr "multiplicity" and the row of
+// every input sequence in attr "groups"
+inline SEXP dedup_result(SEXP result, DedupMode mode, const DuplicateIndex& duplicates,
+                         const vector<double>& self_scores, double threshold, int top_k,
+                         const DenseLayout& layout = DEFAULT_LAYOUT, double scale = 1.0) {
+  if (mode == DEDUP_NONE) {
+    return result;
+  }
+  RObject distinct(result);
+  if (mode == DEDUP_COLLAPSE) {
+    IntegerVector multiplicity(duplicates.multiplicity.begin(), duplicates.multiplicity.end());
+    IntegerVector groups(duplicates.size());
+    for (size_t i = 0; i < duplicates.size(); ++i) {
+      groups[i] = duplicates.group[i] + 1;
+    }
+    distinct.attr("multiplicity") = multiplicity;
+    distinct.attr("groups") = groups;
+    return distinct;
+  }
+
+  bool cut = distinct.hasAttribute("threshold");
+  RObject out;
+  if (Rf_inherits(result, "sparse_similarity")) {
+    out = expand_edges(DataFrame(result), duplicates, self_scores, threshold, top_k,
+                       result_cut(distinct));
+  } else {
+    out = expand_matrix(NumericMatrix(result), duplicates, layout, scale);
+  }
+  if (cut) {
+    out.attr("threshold") = distinct.attr("threshold");
+  }
+  return out;
+}
+
+// Tiled mode of the kernels: the memory budget of one tile, in bytes
+inline double tile_memory_bytes(const string& tile_path, double memory_mb) {
+  if (!tile_path.empty() && !(memory_mb > 0.0)) {
+    Rcpp::stop("'memory_mb' must be positive");
+  }
+  return memory_mb * 1024.0 * 1024.0;
+}
+
+// Called after each finished tile: an interrupt leaves the store resumable
+inline void tile_interrupt(size_t, size_t) {
+  Rcpp::checkUserInterrupt();
+}
+
+// Description of a tile store as an R list
+inline List tile_store_info(const string& path) {
+  TileStore store(path);
+  const TileStoreHeader& header = store.header();
+  bool minhash = header.score == TILE_MINHASH;
+  return List::create(Named("path") = path,
+                      Named("n") = static_cast<double>(header.n),
+                      Named("score") = minhash ? "minhash" : "alignment",
+                      Named("tile") = static_cast<double>(header.tile),
+                      Named("tiles") = static_cast<double>(store.tiles_total()),
+                      Named("tiles_done") = static_cast<double>(store.tiles_done()),
+                      Named("value_bytes") = static_cast<int>(header.value_bytes),
+                      Named("n_hash") = minhash ? static_cast<int>(header.n_hash) : NA_INTEGER,
+                      Named("bits") = minhash ? static_cast<int>(header.bits) : NA_INTEGER,
+                      Named("seed") = minhash ? static_cast<double>(header.seed) : NA_REAL);
+}
+
+// Compare all pairs of signature rows: a dense result in `layout`, with
+// integer and raw entries counting agreeing slots, or with `sparse` a
+// sparse_similarity edge list.
+//
+// With a `cut_quantile` p, the scores are also counted per number of
+// matching slots while they are computed, giving the exact
+// quantile(scores[upper.tri(scores)], p) without collecting them; pairs below
+// it are set to 0 (dense) or dropped (sparse), and the cut is returned in
+// attr(, "threshold").
+//
+// The "compare" and "output" phases and their counters are recorded in
+// `profile`. When the rows are the distinct sequences of `duplicates`, each
+// pair is counted towards the quantile as often as it occurs among all
+// sequences, including the pairs of copies of one sequence.
+inline SEXP pairwise_signature_similarity(const PackedSignatures& signatures, bool sparse,
+                                          double threshold, int top_k, double cut_quantile,
+                                          KernelProfile& profile,
+                                          const DuplicateIndex* duplicates = nullptr,
+                                          const DenseLayout& layout = DEFAULT_LAYOUT) {
+  size_t n = signatures.size();
+  profile.begin("compare");
+  profile.count("threads", max_threads());
+  profile.count("pairs_compared", static_cast<double>(n) * (n > 0 ? n - 1 : 0) / 2);
+  profile.count("bytes_allocated", static_cast<double>(n) * signatures.row_words() * sizeof(uint64_t));
+  size_t tile = signature_tile_rows(signatures);
+  bool cut = !ISNAN(cut_quantile);
+  
+  // Per-thread counts of pairs by matching slots
+  vector<vector<uint64_t>> tallies(cut ? max_threads() : 0,
+                                   vector<uint64_t>(signatures.num_hash() + 1, 0));
+  auto score = [&](size_t i, size_t j) {
+    int agree = signatures.matches(i, j);
+    if (cut) {
+      tallies[current_thread()][agree] += duplicates ? duplicates->pairs(i, j) : 1;
+    }
+    return signatures.similarity_of(agree);
+  };
+  auto quantile = [&]() {
+    if (duplicates) {
+      for (size_t u = 0; u < n; ++u) {
+        tallies[0][signatures.num_hash()] += duplicates->pairs(u, u);  // all slots agree
+      }
+    }
+    ScoreCounts counts;
+    for (int agree = 0; agree <= signatures.num_hash(); ++agree) {
+      uint64_t count = 0;
+      for (const vector<uint64_t>& tally : tallies) {
+        count += tally[agree];
+      }
+      if (count > 0) {
+        counts.push_back(make_pair(signatures.similarity_of(agree), count));
+      }
+    }
+    return score_quantile(counts, cut_quantile);
+  };
+  
+  // Sparse output: keep only the requested pairs, never allocating n x n
+  if (sparse) {
+    SparseSimilarity edges(n, threshold, top_k);
+    for_each_pair_tiled(n, tile, [&](size_t i, size_t j) {
+      edges.add(i, j, score(i, j));
+    });
+    profile.begin("output");
+    profile.count("bytes_allocated", edges.bytes());
+    if (!cut) {
+      return similarity_data_frame(edges);
+    }
+    double q = quantile();
+    DataFrame out = similarity_data_frame(edges, ISNAN(q) ? 0.0 : q);
+    out.attr("threshold") = threshold_value(q);
+    return out;
+  }
+  
+  DenseSimilarity similarityMatrix(n, layout, result_scale(layout, signatures.num_hash()));
+  profile.count("bytes_allocated", similarityMatrix.size_bytes());
+  
+  // Calculate similarities tile by tile in a single parallel region
+  for(size_t i = 0; i < n; ++i) {
+    similarityMatrix.set_diagonal(i, 1.0);
+  }
+  for_each_pair_tiled(n, tile, [&](size_t i, size_t j) {
+    similarityMatrix.set(i, j, score(i, j));
+  });
+  profile.begin("output");
+  
+  RObject out = similarityMatrix.result();
+  if (cut) {
+    double q = quantile();
+    if (!ISNAN(q)) {
+      similarityMatrix.cut(q);
+    }
+    out.attr("threshold") = threshold_value(q);
+  }
+  
+  return out;
+}
+
+#endif // SIMILARITY_RESULT_HPP
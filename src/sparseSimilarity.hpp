@@ -0,0 +1,153 @@
+#ifndef SPARSE_SIMILARITY_HPP
+#define SPARSE_SIMILARITY_HPP
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Namespace declarations
+using namespace std;
+
+// Index of the calling thread (0 outside of parallel regions)
+inline int current_thread() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+// Upper bound on the number of threads a parallel region may use
+inline int max_threads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// A single pair of the sparse similarity graph (0-based, i < j)
+struct SimilarityEdge {
+  int i;
+  int j;
+  double score;
+};
+
+inline bool edge_order(const SimilarityEdge& a, const SimilarityEdge& b) {
+  return a.i < b.i || (a.i == b.i && a.j < b.j);
+}
+
+// Sink for the pairwise kernels when a sparse result is requested.
+//
+// Pairs are kept when their score is positive and at least `threshold`.
+// With `top_k > 0` each sequence additionally keeps only its `top_k` best
+// neighbours; an edge survives if it is in the top-k list of either endpoint.
+// add() may be called concurrently from OpenMP threads.
+class SparseSimilarity {
+private:
+  size_t n;
+  double threshold;
+  int top_k;
+
+  // Threshold-only mode: one edge buffer per thread
+  vector<vector<SimilarityEdge>> buffers;
+
+  // Top-k mode: one bounded min-heap per sequence, guarded by striped locks
+  vector<vector<pair<double, int>>> heaps;
+  vector<std::mutex> locks;
+
+  // Heap order: the worst neighbour (lowest score, then highest index) on top
+  static bool worse(const pair<double, int>& a, const pair<double, int>& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  }
+
+  void offer(int row, int col, double score) {
+    vector<pair<double, int>>& heap = heaps[row];
+    pair<double, int> candidate(score, col);
+    std::lock_guard<std::mutex> guard(locks[row % locks.size()]);
+    if (heap.size() < static_cast<size_t>(top_k)) {
+      heap.push_back(candidate);
+      push_heap(heap.begin(), heap.end(), worse);
+    } else if (worse(candidate, heap.front())) {
+      pop_heap(heap.begin(), heap.end(), worse);
+      heap.back() = candidate;
+      push_heap(heap.begin(), heap.end(), worse);
+    }
+  }
+
+public:
+  SparseSimilarity(size_t n, double threshold = 0.0, int top_k = 0,
+                   int n_threads = max_threads())
+    : n(n), threshold(threshold), top_k(top_k), locks(top_k > 0 ? 256 : 1) {
+    if (top_k > 0) {
+      heaps.resize(n);
+    } else {
+      buffers.resize(max(n_threads, 1));
+    }
+  }
+
+  // Number of sequences
+  size_t nodes() const {
+    return n;
+  }
+
+  bool keeps(double score) const {
+    return score > 0.0 && score >= threshold;
+  }
+
+  void add(int i, int j, double score) {
+    if (!keeps(score)) {
+      return;
+    }
+    if (top_k > 0) {
+      offer(i, j, score);
+      offer(j, i, score);
+    } else {
+      SimilarityEdge edge = {min(i, j), max(i, j), score};
+      buffers[current_thread()].push_back(edge);
+    }
+  }
+
+  // Bytes held by the kept pairs so far
+  size_t bytes() const {
+    size_t total = 0;
+    for (const vector<SimilarityEdge>& buffer : buffers) {
+      total += buffer.capacity() * sizeof(SimilarityEdge);
+    }
+    for (const vector<pair<double, int>>& heap : heaps) {
+      total += heap.capacity() * sizeof(pair<double, int>);
+    }
+    return total;
+  }
+
+  // Collect the kept pairs, sorted by (i, j) and de-duplicated
+  vector<SimilarityEdge> edges() const {
+    vector<SimilarityEdge> out;
+    if (top_k > 0) {
+      for (size_t row = 0; row < heaps.size(); ++row) {
+        for (const pair<double, int>& nb : heaps[row]) {
+          int r = static_cast<int>(row);
+          SimilarityEdge edge = {min(r, nb.second), max(r, nb.second), nb.first};
+          out.push_back(edge);
+        }
+      }
+    } else {
+      for (const vector<SimilarityEdge>& buffer : buffers) {
+        out.insert(out.end(), buffer.begin(), buffer.end());
+      }
+    }
+    sort(out.begin(), out.end(), edge_order);
+    out.erase(unique(out.begin(), out.end(),
+                     [](const SimilarityEdge& a, const SimilarityEdge& b) {
+                       return a.i == b.i && a.j == b.j;
+                     }), out.end());
+    return out;
+  }
+};
+
+#endif // SPARSE_SIMILARITY_HPP
@@ -0,0 +1,101 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include "tileStore.hpp"
+#include "scoreDistribution.hpp"
+#include "similarityResult.hpp"
+
+// Namespace declarations
+using namespace Rcpp;
+using namespace std;
+
+//' @name tileStoreInfo
+//' @title Describe a Tile Store
+//'
+//' @param path A tile store written by [similarityMH()] or [similarityNW()]
+//'        with `tile_path`
+//' @return A list describing the store: `path`, `n` (number of sequences),
+//'         `score` (`"minhash"` or `"alignment"`), `tile` (rows and columns
+//'         per tile), `tiles` and `tiles_done` (the store is complete when
+//'         they are equal), `value_bytes` (bytes per pair), and for MinHash
+//'         `n_hash`, `bits` and `seed`
+//' @export
+// [[Rcpp::export]]
+List tileStoreInfo(std::string path) {
+  return tile_store_info(path);
+}
+
+//' @name readTileStore
+//' @title Read the Similar Pairs of a Tile Store
+//'
+//' @description
+//' Scans a complete tile store, one mapped tile at a time, and returns the
+//' pairs that pass `threshold`, `top_k` and `cut_quantile` as an edge list,
+//' so only the kept pairs are ever held in memory. Every tile is checked
+//' against its fingerprint first: a store whose last tiles never fully
+//' reached the disk (after a crash) is an error, and rerunning the
+//' computation recomputes just those tiles.
+//'
+//' @param path A tile store written by [similarityMH()] or [similarityNW()]
+//'        with `tile_path`
+//' @param threshold Minimum similarity for a pair to be kept (default: 0,
+//'        i.e. every pair with non-zero similarity)
+//' @param top_k If positive, each sequence keeps only its `top_k` most similar
+//'        neighbours (default: 0, no limit)
+//' @param cut_quantile If given, pairs below this quantile of the similarities
+//'        of all pairs are dropped, as in [similarityMH()]; the quantile is
+//'        exact for the stored values, counted in a first pass over the
+//'        tiles (default: NA, no cut)
+//' @return A `sparse_similarity` data frame with 1-based columns `i < j` and
+//'         `score`, and the number of sequences in `attr(, "n")`
+//' @export
+// [[Rcpp::export]]
+DataFrame readTileStore(std::string path, double threshold = 0.0, int top_k = 0,
+                        double cut_quantile = NA_REAL) {
+  if (top_k < 0) {
+    Rcpp::stop("'top_k' must be a non-negative integer");
+  }
+  check_cut_quantile(cut_quantile);
+  TileStore store(path);
+  if (store.tiles_done() < store.tiles_total()) {
+    Rcpp::stop("Tile store is incomplete (%d of %d tiles); rerun the computation to resume it",
+               static_cast<int>(store.tiles_done()), static_cast<int>(store.tiles_total()));
+  }
+  vector<double> scores(store.max_value() + 1);
+  for (size_t v = 0; v < scores.size(); ++v) {
+    scores[v] = store.score_of(static_cast<uint32_t>(v));
+  }
+
+  // First pass: count the pairs per stored value for the quantile
+  bool cut = !ISNAN(cut_quantile);
+  double q = 0.0;
+  if (cut) {
+    vector<vector<uint64_t>> histograms(max_threads(), vector<uint64_t>(scores.size(), 0));
+    store.for_each_pair([&](size_t, size_t, uint32_t value) {
+      ++histograms[current_thread()][value];
+    });
+    ScoreCounts counts;
+    for (size_t v = 0; v < scores.size(); ++v) {
+      uint64_t count = 0;
+      for (const vector<uint64_t>& histogram : histograms) {
+        count += histogram[v];
+      }
+      // NaN similarities are left out, as in the in-memory kernels
+      if (count > 0 && !ISNAN(scores[v])) {
+        counts.push_back(make_pair(scores[v], count));
+      }
+    }
+    q = score_quantile(counts, cut_quantile);
+  }
+
+  SparseSimilarity edges(store.header().n, threshold, top_k);
+  store.for_each_pair([&](size_t i, size_t j, uint32_t value) {
+    edges.add(static_cast<int>(i), static_cast<int>(j), scores[value]);
+  });
+  if (!cut) {
+    return similarity_data_frame(edges);
+  }
+  DataFrame out = similarity_data_frame(edges, ISNAN(q) ? 0.0 : q);
+  out.attr("threshold") = threshold_value(q);
+  return out;
+}
@@ -0,0 +1,520 @@
+#ifndef TILE_STORE_HPP
+#define TILE_STORE_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <limits>
+#include "minHash.hpp"
+#include "needlemanWunsch.hpp"
+#include "packedSignatures.hpp"
+#include "sparseSimilarity.hpp"
+#include "mappedFile.hpp"
+#include "coreError.hpp"
+
+// Add OpenMP if available
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+// On-disk store of all pairwise similarities, for inputs whose n x n matrix
+// does not fit in memory.
+//
+// The upper triangle is cut into square tiles of `tile` rows and columns,
+// numbered row by row (tile (0, 0), (0, 1), ..., (1, 1), ...). A 128-byte
+// header is followed by an index of one 64-bit file offset per tile (0 while
+// the tile is missing) and by the tiles themselves, in the order they were
+// finished. A tile holds its rows x columns values row by row, followed by
+// the 64-bit FNV-1a fingerprint of those values; on tiles of the diagonal
+// only the entries above it are meaningful.
+//
+// Values are quantized: MinHash tiles store the number of agreeing slots
+// (one byte up to 255 slots, two above), alignment tiles the similarity as
+// 16-bit fixed point. A tile is written before its index entry, but the
+// operating system may still reorder the two on their way to disk, so an
+// indexed tile is only trusted when its fingerprint matches: resuming
+// recomputes the tiles that fail it, together with the missing ones, and
+// reading refuses a store that has any.
+const char TILE_STORE_MAGIC[8] = {'D', 'Y', 'N', 'A', 'T', 'I', 'L', '\0'};
+const uint32_t TILE_STORE_VERSION = 2;
+const uint32_t TILE_STORE_BYTE_ORDER = 0x01020304;
+
+// What the stored values are
+enum TileScore { TILE_MINHASH = 1, TILE_ALIGNMENT = 2 };
+
+// Stored alignment value standing for similarity 1
+const double TILE_ALIGNMENT_SCALE = 65534.0;
+
+// Stored alignment value of a NaN similarity (two empty sequences)
+const uint16_t TILE_ALIGNMENT_NAN = 65535;
+
+// Bytes of the fingerprint following the values of each tile
+const uint64_t TILE_CHECKSUM_BYTES = sizeof(uint64_t);
+
+struct TileStoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t score;        // TileScore
+  uint32_t value_bytes;  // bytes per stored value: 1 or 2
+  uint64_t n;            // number of sequences
+  uint64_t tile;         // rows and columns per tile
+  uint64_t input_hash;   // of the sequences
+  uint64_t params_hash;  // of the kernel parameters
+  uint32_t n_hash;       // MinHash slots and bits per slot, to turn agreeing
+  uint32_t bits;         //   slots into similarities
+  uint32_t seed;         // MinHash seed, reused when a run is resumed
+  char reserved[60];
+};
+
+static_assert(sizeof(TileStoreHeader) == 128, "tile store header must be 128 bytes");
+
+// Rows [row_begin, row_end) x columns [col_begin, col_end) of one tile
+struct TileCoord {
+  size_t row_begin;
+  size_t row_end;
+  size_t col_begin;
+  size_t col_end;
+
+  size_t values() const {
+    return (row_end - row_begin) * (col_end - col_begin);
+  }
+};
+
+// 64-bit FNV-1a, stable across platforms and runs
+inline uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Fingerprint of a list of sequences, order included
+inline uint64_t sequences_hash(const vector<string>& seqs) {
+  uint64_t hash = fnv1a(nullptr, 0);
+  for (const string& seq : seqs) {
+    hash = fnv1a(seq.data(), seq.size(), hash);
+    hash = fnv1a("\n", 1, hash);
+  }
+  return hash;
+}
+
+// Tile side that keeps one tile of `value_bytes` values within
+// `memory_bytes`: a multiple of 64 rows when possible, at most n
+inline size_t tile_side(size_t n, double memory_bytes, uint32_t value_bytes) {
+  double side = std::floor(std::sqrt(memory_bytes / value_bytes));
+  size_t tile = side >= 64 ? static_cast<size_t>(side) / 64 * 64 : static_cast<size_t>(side);
+  return max<size_t>(1, min(tile, n));
+}
+
+inline TileStoreHeader make_tile_header(TileScore score, uint32_t value_bytes, size_t n,
+                                        size_t tile, uint64_t input_hash, uint64_t params_hash) {
+  TileStoreHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TILE_STORE_MAGIC, sizeof(header.magic));
+  header.version = TILE_STORE_VERSION;
+  header.byte_order = TILE_STORE_BYTE_ORDER;
+  header.score = score;
+  header.value_bytes = value_bytes;
+  header.n = n;
+  header.tile = tile;
+  header.input_hash = input_hash;
+  header.params_hash = params_hash;
+  return header;
+}
+
+inline void check_tile_header(const TileStoreHeader& header, const string& path) {
+  if (memcmp(header.magic, TILE_STORE_MAGIC, sizeof(header.magic)) != 0) {
+    core_stop("Not a tile store: %s", path);
+  }
+  if (header.version != TILE_STORE_VERSION) {
+    core_stop("Unsupported tile store version %u: %s", header.version, path);
+  }
+  if (header.byte_order != TILE_STORE_BYTE_ORDER) {
+    core_stop("Tile store was written on a machine with a different byte order: %s", path);
+  }
+  if (header.tile == 0 || (header.value_bytes != 1 && header.value_bytes != 2)) {
+    core_stop("Corrupt tile store: %s", path);
+  }
+}
+
+// The tiles of the upper triangle, in index order
+inline vector<TileCoord> tile_grid(const TileStoreHeader& header) {
+  vector<TileCoord> tiles;
+  size_t n = header.n, tile = header.tile;
+  for (size_t i = 0; i < n; i += tile) {
+    for (size_t j = i; j < n; j += tile) {
+      TileCoord coord = {i, min(n, i + tile), j, min(n, j + tile)};
+      tiles.push_back(coord);
+    }
+  }
+  return tiles;
+}
+
+// Byte offset of the first tile
+inline uint64_t tile_data_start(size_t n_tiles) {
+  return sizeof(TileStoreHeader) + n_tiles * sizeof(uint64_t);
+}
+
+// Bytes a tile takes in the file, fingerprint included
+inline uint64_t tile_file_bytes(const TileCoord& coord, uint32_t value_bytes) {
+  return coord.values() * value_bytes + TILE_CHECKSUM_BYTES;
+}
+
+// Whether the values of a tile stored at `data` match their fingerprint
+inline bool tile_intact(const char* data, const TileCoord& coord, uint32_t value_bytes) {
+  uint64_t bytes = coord.values() * value_bytes;
+  uint64_t stored;
+  memcpy(&stored, data + bytes, sizeof(stored));
+  return fnv1a(data, bytes) == stored;
+}
+
+// Writes the tiles of one computation. Opening a store left by an earlier
+// run with the same kind of score, input and parameters resumes it, keeping
+// its tile size and seed; any other file at `path` is replaced.
+class TileStoreWriter {
+private:
+  string path;
+  fstream io;
+  TileStoreHeader head;
+  vector<TileCoord> tiles;
+  vector<uint64_t> offsets;
+  uint64_t append_at;
+
+  bool compatible(const TileStoreHeader& old, const TileStoreHeader& wanted) const {
+    return memcmp(old.magic, TILE_STORE_MAGIC, sizeof(old.magic)) == 0 &&
+      old.version == TILE_STORE_VERSION && old.byte_order == TILE_STORE_BYTE_ORDER &&
+      old.score == wanted.score && old.value_bytes == wanted.value_bytes &&
+      old.n == wanted.n && old.tile > 0 && old.input_hash == wanted.input_hash &&
+      old.params_hash == wanted.params_hash;
+  }
+
+  // Load the header and index of an existing compatible store
+  bool resume(const TileStoreHeader& wanted) {
+    io.open(path.c_str(), ios::in | ios::out | ios::binary);
+    if (!io) {
+      return false;
+    }
+    TileStoreHeader old;
+    if (!io.read(reinterpret_cast<char*>(&old), sizeof(old)) || !compatible(old, wanted)) {
+      io.close();
+      return false;
+    }
+    head = old;
+    tiles = tile_grid(head);
+    offsets.assign(tiles.size(), 0);
+    if (!tiles.empty() &&
+        !io.read(reinterpret_cast<char*>(offsets.data()), offsets.size() * sizeof(uint64_t))) {
+      io.close();
+      return false;
+    }
+    io.seekg(0, ios::end);
+    uint64_t file_size = static_cast<uint64_t>(io.tellg());
+
+    // Tiles must lie entirely within the file and match their fingerprint;
+    // anything else is unindexed and recomputed
+    append_at = tile_data_start(tiles.size());
+    vector<char> data;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+      if (offsets[t] == 0) {
+        continue;
+      }
+      uint64_t bytes = tile_file_bytes(tiles[t], head.value_bytes);
+      bool intact = offsets[t] >= tile_data_start(tiles.size()) && offsets[t] + bytes <= file_size;
+      if (intact) {
+        data.resize(bytes);
+        io.seekg(static_cast<streamoff>(offsets[t]));
+        intact = io.read(data.data(), static_cast<streamsize>(bytes)) &&
+          tile_intact(data.data(), tiles[t], head.value_bytes);
+      }
+      if (intact) {
+        append_at = max(append_at, offsets[t] + bytes);
+      } else {
+        io.clear();
+        offsets[t] = 0;
+        commit(t);
+      }
+    }
+    return true;
+  }
+
+  // Write the index entry of tile t
+  void commit(size_t t) {
+    io.seekp(static_cast<streamoff>(sizeof(head) + t * sizeof(uint64_t)));
+    io.write(reinterpret_cast<const char*>(&offsets[t]), sizeof(uint64_t));
+    io.flush();
+    if (!io) {
+      core_stop("Failed to write tile store: %s", path);
+    }
+  }
+
+public:
+  TileStoreWriter(const string& path, const TileStoreHeader& wanted) : path(path) {
+    if (resume(wanted)) {
+      return;
+    }
+    head = wanted;
+    tiles = tile_grid(head);
+    offsets.assign(tiles.size(), 0);
+    io.open(path.c_str(), ios::in | ios::out | ios::binary | ios::trunc);
+    if (!io) {
+      core_stop("Cannot create tile store: %s", path);
+    }
+    io.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    if (!offsets.empty()) {
+      io.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    }
+    io.flush();
+    if (!io) {
+      core_stop("Failed to write tile store: %s", path);
+    }
+    append_at = tile_data_start(tiles.size());
+  }
+
+  const TileStoreHeader& header() const { return head; }
+  const vector<TileCoord>& grid() const { return tiles; }
+
+  bool done(size_t t) const {
+    return offsets[t] != 0;
+  }
+
+  size_t tiles_done() const {
+    return tiles.size() - count(offsets.begin(), offsets.end(), 0ULL);
+  }
+
+  // Record the MinHash seed of a new store
+  void set_seed(uint32_t seed) {
+    head.seed = seed;
+    io.seekp(0);
+    io.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    io.flush();
+  }
+
+  // Append the values of tile t and their fingerprint, then commit them in
+  // the index
+  void write(size_t t, const void* values) {
+    uint64_t bytes = tiles[t].values() * head.value_bytes;
+    uint64_t fingerprint = fnv1a(static_cast<const char*>(values), bytes);
+    io.seekp(static_cast<streamoff>(append_at));
+    io.write(static_cast<const char*>(values), static_cast<streamsize>(bytes));
+    io.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+    io.flush();
+    if (!io) {
+      core_stop("Failed to write tile store: %s", path);
+    }
+    offsets[t] = append_at;
+    commit(t);
+    append_at += bytes + TILE_CHECKSUM_BYTES;
+  }
+};
+
+// Compute every tile missing from `store` one at a time, with all threads
+// working on the rows of a tile: value(i, j, thread) gives the stored value
+// of pair i < j. after_tile(done, total) is called after each tile is
+// committed, e.g. to check for interrupts; the store stays resumable.
+template <typename T, typename Value, typename After>
+void compute_tiles(TileStoreWriter& store, int n_threads, Value value, After after_tile) {
+  const vector<TileCoord>& tiles = store.grid();
+  size_t tile = store.header().tile;
+  vector<T> values(tile * tile);
+  size_t done = store.tiles_done();
+  for (size_t t = 0; t < tiles.size(); ++t) {
+    if (store.done(t)) {
+      continue;
+    }
+    const TileCoord coord = tiles[t];
+    size_t cols = coord.col_end - coord.col_begin;
+    long rows = static_cast<long>(coord.row_end - coord.row_begin);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+    for (long r = 0; r < rows; ++r) {
+      size_t i = coord.row_begin + r;
+      T* row = values.data() + r * cols;
+      for (size_t c = 0; c < cols; ++c) {
+        size_t j = coord.col_begin + c;
+        row[c] = j > i ? value(i, j, current_thread()) : 0;
+      }
+    }
+    store.write(t, values.data());
+    after_tile(++done, tiles.size());
+  }
+}
+
+// Tile all pairwise MinHash similarities of `seqs` into the store at `path`
+template <typename After>
+TileStoreHeader tile_minhash(const string& path, const vector<string>& seqs, int k, int n_hash,
+                             SketchMethod method, int bits, double memory_bytes, int n_threads,
+                             After after_tile) {
+  uint32_t value_bytes = n_hash <= 255 ? 1 : 2;
+  string params = "minhash k=" + to_string(k) + " n_hash=" + to_string(n_hash) +
+    " method=" + sketch_method_name(method) + " bits=" + to_string(bits);
+  TileStoreHeader wanted = make_tile_header(TILE_MINHASH, value_bytes, seqs.size(),
+                                            tile_side(seqs.size(), memory_bytes, value_bytes),
+                                            sequences_hash(seqs),
+                                            fnv1a(params.data(), params.size()));
+  wanted.n_hash = n_hash;
+  wanted.bits = bits;
+  TileStoreWriter store(path, wanted);
+  if (store.tiles_done() == 0) {
+    store.set_seed(random_device{}());
+  }
+
+  // Every tile compares arbitrary rows, so all signatures stay in memory
+  MinHasher hasher(k, n_hash, method, store.header().seed);
+  PackedSignatures signatures = compute_signatures(seqs, hasher, bits, n_threads);
+  if (value_bytes == 1) {
+    compute_tiles<uint8_t>(store, n_threads, [&](size_t i, size_t j, int) {
+      return static_cast<uint8_t>(signatures.matches(i, j));
+    }, after_tile);
+  } else {
+    compute_tiles<uint16_t>(store, n_threads, [&](size_t i, size_t j, int) {
+      return static_cast<uint16_t>(signatures.matches(i, j));
+    }, after_tile);
+  }
+  return store.header();
+}
+
+// Tile all pairwise alignment similarities of `seqs` into the store at
+// `path`, with the scalar kernel (one pair at a time, banded and abandoned
+// below `cutoff` as in calculate_similarity())
+template <typename After>
+TileStoreHeader tile_alignments(const string& path, const vector<string>& seqs,
+                                const string& matrixName, int gapOpen, int gapExt, int band,
+                                double cutoff, double memory_bytes, int n_threads,
+                                After after_tile) {
+  char params[160];
+  snprintf(params, sizeof(params), "alignment matrix=%s open=%d ext=%d band=%d cutoff=%.17g",
+           matrixName.c_str(), gapOpen, gapExt, band, cutoff);
+  TileStoreHeader wanted = make_tile_header(TILE_ALIGNMENT, 2, seqs.size(),
+                                            tile_side(seqs.size(), memory_bytes, 2),
+                                            sequences_hash(seqs), fnv1a(params, strlen(params)));
+  const int (*substitutionMatrix)[24] = getSubstitutionMatrix(matrixName);
+  vector<vector<uint8_t>> encoded = encode_sequences(seqs);
+  TileStoreWriter store(path, wanted);
+  vector<NWWorkspace> workspaces(n_threads);
+  compute_tiles<uint16_t>(store, n_threads, [&](size_t i, size_t j, int thread) {
+    double similarity = calculate_similarity(encoded[i], encoded[j], substitutionMatrix,
+                                             gapOpen, gapExt, workspaces[thread], band, cutoff);
+    if (std::isnan(similarity)) {
+      return TILE_ALIGNMENT_NAN;
+    }
+    return static_cast<uint16_t>(std::lround(similarity * TILE_ALIGNMENT_SCALE));
+  }, after_tile);
+  return store.header();
+}
+
+// A tile store mapped into memory for reading
+class TileStore {
+private:
+  MappedFile file;
+  TileStoreHeader head;
+  vector<TileCoord> tiles;
+  const uint64_t* offsets;
+
+public:
+  explicit TileStore(const string& path) : file(path, "tile store") {
+    if (file.size() < sizeof(TileStoreHeader)) {
+      core_stop("Not a tile store: %s", path);
+    }
+    memcpy(&head, file.data(), sizeof(head));
+    check_tile_header(head, path);
+    tiles = tile_grid(head);
+    if (file.size() < tile_data_start(tiles.size())) {
+      core_stop("Tile store is truncated: %s", path);
+    }
+    offsets = reinterpret_cast<const uint64_t*>(file.data() + sizeof(head));
+    for (size_t t = 0; t < tiles.size(); ++t) {
+      if (offsets[t] != 0 && offsets[t] + tile_file_bytes(tiles[t], head.value_bytes) > file.size()) {
+        core_stop("Tile store is truncated: %s", path);
+      }
+    }
+
+    // Indexed tiles whose data never fully reached the disk
+    long n_tiles = static_cast<long>(tiles.size());
+    long damaged = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:damaged)
+#endif
+    for (long t = 0; t < n_tiles; ++t) {
+      if (offsets[t] != 0 && !tile_intact(file.data() + offsets[t], tiles[t], head.value_bytes)) {
+        ++damaged;
+      }
+    }
+    if (damaged > 0) {
+      core_stop("Tile store is corrupt (%ld tiles fail their checksum); rerun the computation "
+                "to recompute them: %s", damaged, path);
+    }
+  }
+
+  const TileStoreHeader& header() const { return head; }
+
+  size_t tiles_total() const {
+    return tiles.size();
+  }
+
+  size_t tiles_done() const {
+    size_t done = 0;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+      done += offsets[t] != 0;
+    }
+    return done;
+  }
+
+  // Largest stored value
+  uint32_t max_value() const {
+    return head.score == TILE_MINHASH ? head.n_hash : TILE_ALIGNMENT_NAN;
+  }
+
+  // Similarity of a stored value
+  double score_of(uint32_t value) const {
+    if (head.score == TILE_MINHASH) {
+      return signature_similarity(static_cast<int>(value), head.n_hash, head.bits);
+    }
+    if (value == TILE_ALIGNMENT_NAN) {
+      return numeric_limits<double>::quiet_NaN();
+    }
+    return value / TILE_ALIGNMENT_SCALE;
+  }
+
+  // Call visit(i, j, value) for every pair i < j of the stored tiles, with
+  // the tiles shared among threads
+  template <typename F>
+  void for_each_pair(F visit) const {
+    long n_tiles = static_cast<long>(tiles.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (long t = 0; t < n_tiles; ++t) {
+      if (offsets[t] == 0) {
+        continue;
+      }
+      const TileCoord& coord = tiles[t];
+      const char* data = file.data() + offsets[t];
+      size_t cols = coord.col_end - coord.col_begin;
+      for (size_t i = coord.row_begin; i < coord.row_end; ++i) {
+        size_t r = i - coord.row_begin;
+        for (size_t j = max(coord.col_begin, i + 1); j < coord.col_end; ++j) {
+          size_t e = r * cols + (j - coord.col_begin);
+          uint32_t value;
+          if (head.value_bytes == 1) {
+            value = static_cast<const uint8_t*>(static_cast<const void*>(data))[e];
+          } else {
+            uint16_t wide;
+            memcpy(&wide, data + 2 * e, sizeof(wide));
+            value = wide;
+          }
+          visit(i, j, value);
+        }
+      }
+    }
+  }
+};
+
+#endif // TILE_STORE_HPP